@@ -2,10 +2,10 @@ import { useEffect } from "react";
 import { Routes, Route, useNavigate } from "react-router-dom";
 import Home from "./Home.jsx";
 import Expr from "./Expr.jsx";
-import useWasm from "./hooks/Wasm.js";
+import { useWasmPool } from "./hooks/Wasm.js";
 
 export default function App() {
-  const wasm = useWasm();
+  const pool = useWasmPool();
   const navigate = useNavigate();
 
   useEffect(() => {
@@ -18,8 +18,8 @@ export default function App() {
 
   return (
     <Routes>
-      <Route path="/" element={<Home wasm={wasm} />} />
-      <Route path="/:n" element={<Expr wasm={wasm} />} />
+      <Route path="/" element={<Home pool={pool} />} />
+      <Route path="/:n" element={<Expr pool={pool} />} />
     </Routes>
   );
 }
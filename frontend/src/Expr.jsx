@@ -1,9 +1,9 @@
 import React, { useState, useEffect } from "react";
 import { useParams, useNavigate, Link as RouterLink } from "react-router-dom";
-import Graph from "../src/components/Graph";
+import Graph, { treeToElkGraph } from "../src/components/Graph";
 import AnimatedText from "../src/components/AnimatedText";
 
-export default function Expr({ wasm }) {
+export default function Expr({ pool }) {
   const { n } = useParams();
   const navigate = useNavigate();
   const [search, setSearch] = useState(n);
@@ -11,18 +11,38 @@ export default function Expr({ wasm }) {
   const [exprTree, setExprTree] = useState(null);
   const [evaluationResult, setEvaluationResult] = useState(null);
   const [truthTable, setTruthTable] = useState([]);
+  // stable_count(): indices from here on were renumbered when sizes past
+  // 99 became complete, so older links to them open a different expression
+  const [stableCount, setStableCount] = useState(null);
 
   useEffect(() => {
-    if (!wasm) return;
-    try {
-      const parsed = JSON.parse(wasm.get_expr_full(n));
-      setExpr(parsed.expr);
-      setExprTree(parsed.tree);
-    } catch {
-      setExpr("Invalid index");
-      setExprTree(null);
-    }
-  }, [wasm, n]);
+    if (!pool) return;
+    pool.call("stable_count").then((c) => setStableCount(BigInt(c)));
+  }, [pool]);
+
+  const renumbered =
+    stableCount != null && /^\d+$/.test(n) && BigInt(n) >= stableCount;
+
+  // unranked off the main thread; a stale answer for a previous n is dropped
+  useEffect(() => {
+    if (!pool) return;
+    let current = true;
+    pool
+      .call("get_expr_tree", n)
+      .then((tree) => {
+        if (!current) return;
+        setExpr(tree.expr);
+        setExprTree({ ...treeToElkGraph(tree), n });
+      })
+      .catch(() => {
+        if (!current) return;
+        setExpr("Invalid index");
+        setExprTree(null);
+      });
+    return () => {
+      current = false;
+    };
+  }, [pool, n]);
 
   const doSearch = () => {
     if (/^\d+$/.test(search)) navigate(`/${search}`);
@@ -42,14 +62,14 @@ export default function Expr({ wasm }) {
             value={search}
             onChange={(e) => setSearch(e.target.value)}
             onKeyDown={(e) => e.key === "Enter" && doSearch()}
-            disabled={!wasm}
+            disabled={!pool}
           />
           <button
             className="btn btn-hover btn-large"
             onClick={doSearch}
-            disabled={!wasm}
+            disabled={!pool}
           >
-            {wasm ? "Go" : "…"}
+            {pool ? "Go" : "…"}
           </button>
         </div>
       </header>
@@ -62,13 +82,18 @@ export default function Expr({ wasm }) {
           <pre className="font-mono break-words whitespace-pre-wrap">
             {expr}
           </pre>
+          {renumbered && (
+            <p className="text-sm font-serif mt-4">
+              Indices of size 100 and above were renumbered; links made before
+              the change open a different expression here.
+            </p>
+          )}
         </div>
 
         <div className="card overflow-hidden flex">
           <Graph
             tree={exprTree}
-            wasm={wasm}
-            n={n}
+            pool={pool}
             onEvaluate={setEvaluationResult}
             onTruthTable={setTruthTable}
           />
@@ -2,14 +2,14 @@ import React, { useState, useEffect } from "react";
 import { useNavigate } from "react-router-dom";
 import AnimatedText from "../src/components/AnimatedText";
 
-export default function Home({ wasm }) {
+export default function Home({ pool }) {
   const [search, setSearch] = useState("");
   const [count, setCount] = useState("…");
   const navigate = useNavigate();
 
   useEffect(() => {
-    if (wasm) setCount(wasm.get_expr_count());
-  }, [wasm]);
+    if (pool) pool.call("get_expr_count").then(setCount);
+  }, [pool]);
 
   const doSearch = () => {
     if (/^\d+$/.test(search)) navigate(`/${search}`);
@@ -32,14 +32,14 @@ export default function Home({ wasm }) {
             value={search}
             onChange={(e) => setSearch(e.target.value)}
             onKeyDown={(e) => e.key === "Enter" && doSearch()}
-            disabled={!wasm}
+            disabled={!pool}
           />
           <button
             className="btn btn-hover btn-large"
             onClick={doSearch}
-            disabled={!wasm}
+            disabled={!pool}
           >
-            {wasm ? "Go" : "…"}
+            {pool ? "Go" : "…"}
           </button>
         </div>
 
@@ -1,4 +1,10 @@
-import React, { useEffect, useState, useMemo, useCallback } from "react";
+import React, {
+  useEffect,
+  useState,
+  useMemo,
+  useCallback,
+  useRef,
+} from "react";
 import ReactFlow, {
   ReactFlowProvider,
   useReactFlow,
@@ -46,55 +52,70 @@ function LogicNode({ id, data }) {
 
 const nodeTypes = { logic: LogicNode };
 
-function extractVariables(tree) {
-  const vars = new Set();
-  const stack = [tree];
-  while (stack.length) {
-    const n = stack.pop();
-    if (!n) continue;
-    if (typeof n === "string") {
-      vars.add(n);
-    } else if (n.type === "VAR") {
-      vars.add(n.value);
-    } else if (n.type === "NOT") {
-      stack.push(n.child);
-    } else {
-      stack.push(n.left, n.right);
-    }
+// get_expr_tree opcodes (NodeOp in flat_expr.h)
+const OP_VAR = 0;
+const OP_NOT = 1;
+const OP_NAMES = ["VAR", "NOT", "AND", "OR", "XOR"];
+
+// Label id -> name, bijective base 26 like the C++ Labels table
+function labelName(id) {
+  let s = "";
+  for (let x = id; ; x--) {
+    s = String.fromCharCode(65 + (x % 26)) + s;
+    x = Math.floor(x / 26);
+    if (x === 0) break;
   }
+  return s;
+}
 
-  return Array.from(vars).sort(
-    (a, b) => a.length - b.length || a.localeCompare(b),
-  );
+// Variable i is bit i of the mask passed to CompiledExpr.eval/evalNodes
+function inputMask(variables, varStates) {
+  const mask = new Uint32Array(Math.max(1, Math.ceil(variables.length / 32)));
+  variables.forEach((v, i) => {
+    if (varStates[v]) mask[i >> 5] |= 1 << (i & 31);
+  });
+  return mask;
+}
+
+// Node ids are n<preorder index>
+function nodeIndex(node) {
+  return Number(node.id.slice(1));
+}
+
+function withValue(node, value) {
+  return {
+    ...node,
+    data: { ...node.data, backgroundClass: value ? TRUE_BG : FALSE_BG },
+  };
 }
 
-function treeToElkGraph(tree) {
-  let counter = 0;
+// Walks get_expr_tree's preorder views (ops/labels point into WASM memory,
+// so call this before the next wasm call). Node ids n<i> are preorder
+// positions, matching evaluate_expr_full_json.
+export function treeToElkGraph({ ops, labels, vars }) {
   const nodes = [];
   const edges = [];
-  function build(n, parentId) {
-    const myId = `n${counter++}`;
-    const isLeaf = typeof n === "string" || n.type === "VAR";
-    const label = isLeaf ? (typeof n === "string" ? n : n.value) : n.type;
-    nodes.push({ id: myId, label });
-    if (parentId) {
+  const open = []; // internal nodes still missing children
+  for (let i = 0; i < ops.length; i++) {
+    const myId = `n${i}`;
+    const op = ops[i];
+    nodes.push({
+      id: myId,
+      label: op === OP_VAR ? labelName(labels[i]) : OP_NAMES[op],
+    });
+    if (open.length) {
+      const parent = open[open.length - 1];
       edges.push({
-        id: `${parentId}-${myId}`,
-        sources: [parentId],
+        id: `${parent.id}-${myId}`,
+        sources: [parent.id],
         targets: [myId],
       });
+      if (--parent.missing === 0) open.pop();
     }
-    if (!isLeaf) {
-      if (n.type === "NOT") {
-        build(n.child, myId);
-      } else {
-        build(n.left, myId);
-        build(n.right, myId);
-      }
-    }
+    if (op !== OP_VAR) open.push({ id: myId, missing: op === OP_NOT ? 1 : 2 });
   }
-  build(tree, null);
-  return { nodes, edges };
+  const variables = Array.from({ length: vars }, (_, i) => labelName(i));
+  return { nodes, edges, variables };
 }
 
 const ELK_OPTIONS = {
@@ -107,24 +128,24 @@ const ELK_OPTIONS = {
   "elk.spacing.edgeEdge": "10",
 };
 
-function GraphInner({ tree, wasm, n, onEvaluate, onTruthTable }) {
+function GraphInner({ tree, pool, onEvaluate, onTruthTable }) {
   const { fitView } = useReactFlow();
 
   const [nodesMeta, setNodesMeta] = useState([]);
   const [edges, setEdges] = useState([]);
   const [varStates, setVarStates] = useState({});
 
-  const variables = useMemo(() => extractVariables(tree), [tree]);
+  const variables = useMemo(() => tree?.variables ?? [], [tree]);
 
   useEffect(() => {
-    if (!tree || !wasm) return;
+    if (!tree || !pool) return;
     setNodesMeta([]);
     setEdges([]);
     setVarStates(Object.fromEntries(variables.map((v) => [v, true])));
 
     let active = true;
     (async () => {
-      const { nodes: rawNodes, edges: rawRawEdges } = treeToElkGraph(tree);
+      const { nodes: rawNodes, edges: rawRawEdges } = tree;
       const layout = await elk.layout({
         id: "root",
         layoutOptions: ELK_OPTIONS,
@@ -183,44 +204,105 @@ function GraphInner({ tree, wasm, n, onEvaluate, onTruthTable }) {
     return () => {
       active = false;
     };
-  }, [tree, wasm, variables, fitView]);
+  }, [tree, pool, variables, fitView]);
+
+  // Compiled once per expression, in the pool worker that fetched the tree
+  // (from its cache, for the index the tree came from: tree.n, not the
+  // route's); toggles only re-run the compiled program there
+  const [program, setProgram] = useState(null);
+  useEffect(() => {
+    if (!pool || !tree) return;
+    let active = true;
+    let compiled = null;
+    pool
+      .compile(tree.n)
+      .then((c) => {
+        if (!active) return c.delete();
+        compiled = c;
+        setProgram(c);
+      })
+      .catch(() => active && setProgram(null));
+    return () => {
+      active = false;
+      compiled?.delete();
+      setProgram(null);
+    };
+  }, [pool, tree]);
+
+  // Full evaluation once per layout; toggles then flip one input in the
+  // compiled program and patch only the nodes whose value changed. The
+  // node bits and the inputs they were computed for are mirrored here, so
+  // a flip's changed ids are enough to update both.
+  const [nodes, setNodes] = useState([]);
+  const varStatesRef = useRef(varStates);
+  varStatesRef.current = varStates;
+  const bitsRef = useRef(null);
+  const appliedRef = useRef({});
+  const programRef = useRef(program);
+  programRef.current = program;
 
-  const nodes = useMemo(() => {
-    if (!nodesMeta.length || !wasm) return [];
-    let resultMap = {};
-    try {
-      resultMap = JSON.parse(
-        wasm.evaluate_expr_full_json(n, JSON.stringify(varStates)),
+  useEffect(() => {
+    bitsRef.current = null;
+    if (!nodesMeta.length || !program) {
+      setNodes([]);
+      return;
+    }
+    let active = true;
+    const inputs = { ...varStatesRef.current };
+    program.evalNodes(inputMask(variables, inputs)).then((bits) => {
+      if (!active) return;
+      bitsRef.current = bits;
+      appliedRef.current = inputs;
+      setNodes(
+        nodesMeta.map((node) => {
+          const i = nodeIndex(node);
+          return withValue(node, (bits[i >> 5] >>> (i & 31)) & 1);
+        }),
       );
-    } catch {}
-    return nodesMeta.map((node) => {
-      const val = resultMap[node.id];
-      const bg = val === undefined ? DEFAULT_BG : val ? TRUE_BG : FALSE_BG;
-      return {
-        ...node,
-        data: { ...node.data, backgroundClass: bg },
-      };
     });
-  }, [nodesMeta, varStates, wasm, n]);
+    return () => {
+      active = false;
+    };
+  }, [nodesMeta, program, variables]);
+
+  const slotOf = useMemo(
+    () => new Map(nodesMeta.map((node, k) => [nodeIndex(node), k])),
+    [nodesMeta],
+  );
 
   useEffect(() => {
-    if (!nodesMeta.length || !wasm) return;
-    let resultMap = {};
-    try {
-      resultMap = JSON.parse(
-        wasm.evaluate_expr_full_json(n, JSON.stringify(varStates)),
-      );
-    } catch {}
-    const out = resultMap["n0"] ?? null;
-    onEvaluate?.(out ? "true" : "false");
-    onTruthTable?.([
-      { inputs: { ...varStates }, output: out ? "true" : "false" },
-    ]);
-  }, [nodesMeta, varStates, wasm, n, onEvaluate, onTruthTable]);
+    const bits = bitsRef.current;
+    if (!nodes.length || !bits) return;
+    const out = bits[0] & 1 ? "true" : "false";
+    onEvaluate?.(out);
+    onTruthTable?.([{ inputs: { ...appliedRef.current }, output: out }]);
+  }, [nodes, onEvaluate, onTruthTable]);
 
   const toggleVariable = useCallback(
-    (v) => setVarStates((prev) => ({ ...prev, [v]: !prev[v] })),
-    [],
+    (v) => {
+      setVarStates((prev) => ({ ...prev, [v]: !prev[v] }));
+      if (!program) return;
+      program.flip(variables.indexOf(v)).then((changed) => {
+        const bits = bitsRef.current;
+        if (!bits || programRef.current !== program) return; // superseded
+        appliedRef.current = {
+          ...appliedRef.current,
+          [v]: !appliedRef.current[v],
+        };
+        for (const i of changed) bits[i >> 5] ^= 1 << (i & 31);
+        setNodes((prev) => {
+          if (!prev.length) return prev;
+          const next = prev.slice();
+          for (const i of changed) {
+            const k = slotOf.get(i);
+            if (k !== undefined)
+              next[k] = withValue(next[k], (bits[i >> 5] >>> (i & 31)) & 1);
+          }
+          return next;
+        });
+      });
+    },
+    [program, variables, slotOf],
   );
 
   return (
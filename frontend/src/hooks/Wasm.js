@@ -1,22 +1,181 @@
 import { useState, useEffect } from "react";
 
-let modulePromise = null;
+let poolPromise = null;
 
-export default function useWasm() {
-  const [mod, setMod] = useState(null);
+// Smallest module using 128-bit SIMD (i8x16.splat, i8x16.popcnt); it only
+// validates on engines that implement the final SIMD proposal
+const SIMD_PROBE = new Uint8Array([
+  0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1,
+  8, 0, 65, 0, 253, 15, 253, 98, 11,
+]);
 
-  useEffect(() => {
-    if (!modulePromise) {
-      const s = document.createElement("script");
-      s.src = `${import.meta.env.BASE_URL}wasm_main.js`;
-      document.body.appendChild(s);
-
-      modulePromise = new Promise((resolve) => {
-        s.onload = () => window.createModule().then(resolve);
-      });
+export function wasmSimdAvailable() {
+  try {
+    return WebAssembly.validate(SIMD_PROBE);
+  } catch {
+    return false;
+  }
+}
+
+/* Shared memory (and so wasm_main_mt) is only available to cross-origin
+ * isolated pages, i.e. served with COOP: same-origin and COEP: require-corp */
+export function wasmThreadsAvailable() {
+  return (
+    typeof SharedArrayBuffer !== "undefined" &&
+    globalThis.crossOriginIsolated === true
+  );
+}
+
+// Single-index lookups served by the module's hot-index cache. Every
+// worker has its own cache, so these all go to the first worker: its
+// N±k prefetch then turns browsing to a neighbour into a hit even while
+// earlier calls are still pending. compile() goes there too, so the
+// expression just fetched is compiled without unranking it again.
+const CACHED_CALLS = new Set(["get_expr_tree", "get_expr_full", "compile"]);
+
+/* Module bindings run in Web Workers; call(fn, ...args) resolves with the
+ * result. With threads (and SIMD, which wasm_main_mt is built with)
+ * available one worker hosts wasm_main_mt, whose pthread pool splits range
+ * queries. Otherwise `size` workers each host wasm_main_simd or wasm_main;
+ * cached lookups go to the first one and other calls to the least busy
+ * one. Typed arrays come back as copies. compile(n) resolves with a proxy
+ * for a CompiledExpr kept in that worker. */
+export class WasmPool {
+  static async create({
+    size,
+    simd = wasmSimdAvailable(),
+    threaded = simd && wasmThreadsAvailable(),
+  } = {}) {
+    const count = threaded
+      ? 1
+      : (size ?? Math.min(4, navigator.hardwareConcurrency || 1));
+    const name = threaded
+      ? "wasm_main_mt"
+      : simd
+        ? "wasm_main_simd"
+        : "wasm_main";
+    const workers = await Promise.all(
+      Array.from({ length: count }, () => startWorker(name)),
+    );
+    return new WasmPool(workers, threaded);
+  }
+
+  constructor(workers, threaded) {
+    this.workers = workers;
+    this.threaded = threaded;
+    this.threads = workers.reduce((t, w) => t + w.threads, 0);
+    this.nextId = 0;
+  }
+
+  call(fn, ...args) {
+    const w = CACHED_CALLS.has(fn)
+      ? this.workers[0]
+      : this.workers.reduce((a, b) =>
+          b.pending.size < a.pending.size ? b : a,
+        );
+    return this.post(w, fn, args);
+  }
+
+  /* { vars, nodes, evalNodes(mask), flip(v), delete() } for expression n;
+   * the methods resolve with CompiledExpr's results and run in order on
+   * the worker holding it */
+  async compile(n) {
+    const w = this.workers[0];
+    const { handle, vars, nodes } = await this.post(w, "compile", [n]);
+    const on = (method, ...args) =>
+      this.post(w, "compiled", [handle, method, ...args]);
+    return {
+      vars,
+      nodes,
+      evalNodes: (mask) => on("evalNodes", mask),
+      flip: (v) => on("flip", v),
+      delete: () => {
+        if (this.workers.includes(w))
+          this.post(w, "release", [handle]).catch(() => {});
+      },
+    };
+  }
+
+  post(w, fn, args) {
+    const id = this.nextId++;
+    return new Promise((resolve, reject) => {
+      w.pending.set(id, { resolve, reject });
+      w.worker.postMessage({ id, fn, args });
+    });
+  }
+
+  terminate() {
+    for (const w of this.workers) {
+      w.worker.terminate();
+      for (const p of w.pending.values())
+        p.reject(new Error("WasmPool terminated"));
     }
-    modulePromise.then(setMod);
+    this.workers = [];
+  }
+}
+
+function startWorker(name) {
+  const worker = new Worker(new URL("./wasm.worker.js", import.meta.url));
+  const w = { worker, pending: new Map(), threads: 1 };
+  return new Promise((resolve, reject) => {
+    worker.onerror = reject;
+    worker.onmessage = ({ data }) => {
+      if (data.type === "ready") {
+        w.threads = data.threads;
+        worker.onerror = null;
+        resolve(w);
+        return;
+      }
+      if (data.type === "failed") {
+        worker.terminate();
+        reject(new Error(data.error));
+        return;
+      }
+      const p = w.pending.get(data.id);
+      w.pending.delete(data.id);
+      if ("error" in data) p.reject(new Error(data.error));
+      else p.resolve(data.result);
+    };
+    worker.postMessage({
+      type: "init",
+      base: new URL(import.meta.env.BASE_URL, location.href).href,
+      name,
+    });
+  });
+}
+
+/* Shared WasmPool, null until its workers have loaded. A pool whose
+ * module fails to start (e.g. wasm_main_mt missing) falls back one step:
+ * threaded → SIMD → scalar. */
+export function useWasmPool() {
+  const [pool, setPool] = useState(null);
+
+  useEffect(() => {
+    if (!poolPromise)
+      poolPromise = WasmPool.create()
+        .catch(() => WasmPool.create({ threaded: false }))
+        .catch(() => WasmPool.create({ simd: false, threaded: false }));
+    poolPromise.then(setPool);
   }, []);
 
-  return mod;
+  return pool;
+}
+
+/* BigInt <-> little-endian magnitude bytes, the binary index form accepted
+ * by every index argument and returned by the *_bytes entry points */
+export function bigIntToBytes(n) {
+  if (n === 0n) return new Uint8Array(0);
+  let hex = n.toString(16);
+  if (hex.length % 2) hex = "0" + hex;
+  const out = new Uint8Array(hex.length / 2);
+  for (let i = 0; i < out.length; i++)
+    out[i] = parseInt(hex.slice(hex.length - 2 * i - 2, hex.length - 2 * i), 16);
+  return out;
+}
+
+export function bytesToBigInt(bytes) {
+  let hex = "";
+  for (let i = bytes.length - 1; i >= 0; i--)
+    hex += bytes[i].toString(16).padStart(2, "0");
+  return hex ? BigInt("0x" + hex) : 0n;
 }
@@ -0,0 +1,70 @@
+/* global importScripts, createModule */
+// Hosts one module instance off the main thread for WasmPool (Wasm.js).
+// init: { type: "init", base, name } loads `${base}${name}.js` and answers
+// "ready" (with the module's thread_count()) or "failed";
+// calls: { id, fn, args } answer { id, result } or { id, error }.
+// CompiledExpr handles stay in this worker; the pool reaches them through
+// the compile / compiled / release calls below.
+
+let mod = null;
+const handles = new Map();
+let nextHandle = 0;
+
+const COMPILED_METHODS = new Set(["eval", "evalNodes", "flip", "value"]);
+
+// Calls served here rather than by a module binding
+const local = {
+  compile(n) {
+    const c = mod.compile(n);
+    const handle = nextHandle++;
+    handles.set(handle, c);
+    return { handle, vars: c.vars(), nodes: c.nodes() };
+  },
+  compiled(handle, method, ...args) {
+    const c = handles.get(handle);
+    if (!c || !COMPILED_METHODS.has(method))
+      throw new Error(`No CompiledExpr call ${method} on ${handle}`);
+    return c[method](...args);
+  },
+  release(handle) {
+    handles.get(handle)?.delete();
+    handles.delete(handle);
+  },
+};
+
+// Typed-array results (get_expr_tree, truth_table) may be views into WASM
+// memory; posting those would clone the whole heap, so copy them out.
+function detach(v) {
+  if (ArrayBuffer.isView(v)) return v.slice();
+  if (v && typeof v === "object" && !Array.isArray(v)) {
+    const out = {};
+    for (const [k, x] of Object.entries(v)) out[k] = detach(x);
+    return out;
+  }
+  return v;
+}
+
+self.onmessage = async ({ data }) => {
+  if (data.type === "init") {
+    const script = `${data.base}${data.name}.js`;
+    try {
+      importScripts(script);
+      mod = await createModule({
+        locateFile: (path) => `${data.base}${path}`,
+        mainScriptUrlOrBlob: script,
+      });
+      self.postMessage({ type: "ready", threads: mod.thread_count() });
+    } catch (e) {
+      self.postMessage({ type: "failed", error: String(e?.message ?? e) });
+    }
+    return;
+  }
+
+  const { id, fn, args } = data;
+  try {
+    const f = Object.hasOwn(local, fn) ? local[fn] : mod[fn];
+    self.postMessage({ id, result: detach(f(...args)) });
+  } catch (e) {
+    self.postMessage({ id, error: String(e?.message ?? e) });
+  }
+};
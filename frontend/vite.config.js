@@ -1,8 +1,17 @@
 import { defineConfig } from "vite";
 import react from "@vitejs/plugin-react";
 
+const isolation = {
+  "Cross-Origin-Opener-Policy": "same-origin",
+  "Cross-Origin-Embedder-Policy": "require-corp",
+};
+
 // https://vite.dev/config/
 export default defineConfig({
   base: "/circfinity/",
   plugins: [react()],
+  // cross-origin isolation lets the worker pool load wasm_main_mt; hosts
+  // without these headers (GitHub Pages) get the single-threaded module
+  server: { headers: isolation },
+  preview: { headers: isolation },
 });
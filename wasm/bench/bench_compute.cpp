@@ -0,0 +1,283 @@
+#include "compute.h"
+#include "compute_data.h"
+#include "instrument.h"
+#include "sampler.h"
+#include "tiered.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Micro-benchmarks for the unranking hot paths.
+ *
+ * Each case runs with a doubling iteration count until one batch takes at
+ * least --min-time seconds; allocations are counted by replacing the
+ * global operator new. Results go to stdout (or -o FILE) as JSON or CSV:
+ * name, iterations, ns/op, ops/s, allocations/op, bytes/op. */
+
+#if CIRCFINITY_INSTRUMENT
+
+/* the instrumented compute_lib already counts through operator new */
+namespace {
+std::size_t alloc_count() { return instrument::snapshot().allocs; }
+std::size_t alloc_bytes() { return instrument::snapshot().allocBytes; }
+} // namespace
+
+#else
+
+namespace {
+std::size_t g_allocs = 0, g_allocBytes = 0;
+std::size_t alloc_count() { return g_allocs; }
+std::size_t alloc_bytes() { return g_allocBytes; }
+} // namespace
+
+void *operator new(std::size_t n) {
+    ++g_allocs;
+    g_allocBytes += n;
+    if (void *p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    std::string name;
+    std::uint64_t iterations;
+    double nsPerOp, allocsPerOp, bytesPerOp;
+};
+
+struct Options {
+    std::string format = "json", out, filter;
+    double minTime = 0.2;
+};
+
+/* Keeps a computed value alive so the call is not optimised away */
+template <class T> void keep(const T &v) {
+    asm volatile("" : : "g"(&v) : "memory");
+}
+
+class Runner {
+  public:
+    explicit Runner(const Options &o) : opts_(o) {}
+
+    template <class F> void run(const std::string &name, F &&f) {
+        if (!selected(name))
+            return;
+        f(); // warm caches and lazily built tables
+        for (std::uint64_t iters = 1;; iters *= 2) {
+            auto r = measure(name, iters, f);
+            double secs = r.nsPerOp * double(iters) * 1e-9;
+            if (secs >= opts_.minTime || iters >= (1ULL << 32)) {
+                results_.push_back(r);
+                return;
+            }
+        }
+    }
+
+    /* For work that only happens once per process */
+    template <class F> void once(const std::string &name, F &&f) {
+        if (selected(name))
+            results_.push_back(measure(name, 1, f));
+    }
+
+    void report(std::ostream &out) const {
+        if (opts_.format == "csv") {
+            out << "name,iterations,ns_per_op,ops_per_sec,allocs_per_op,"
+                   "bytes_per_op\n";
+            for (const auto &r : results_)
+                out << r.name << ',' << r.iterations << ',' << r.nsPerOp
+                    << ',' << 1e9 / r.nsPerOp << ',' << r.allocsPerOp << ','
+                    << r.bytesPerOp << '\n';
+            return;
+        }
+        out << "[\n";
+        for (std::size_t i = 0; i < results_.size(); ++i) {
+            const auto &r = results_[i];
+            out << "  {\"name\":\"" << r.name
+                << "\",\"iterations\":" << r.iterations
+                << ",\"ns_per_op\":" << r.nsPerOp
+                << ",\"ops_per_sec\":" << 1e9 / r.nsPerOp
+                << ",\"allocs_per_op\":" << r.allocsPerOp
+                << ",\"bytes_per_op\":" << r.bytesPerOp << '}'
+                << (i + 1 < results_.size() ? ",\n" : "\n");
+        }
+        out << "]\n";
+    }
+
+  private:
+    bool selected(const std::string &name) const {
+        return opts_.filter.empty() ||
+               name.find(opts_.filter) != std::string::npos;
+    }
+
+    template <class F>
+    static Result measure(const std::string &name, std::uint64_t iters,
+                          F &f) {
+        std::size_t a0 = alloc_count(), b0 = alloc_bytes();
+        auto t0 = Clock::now();
+        for (std::uint64_t i = 0; i < iters; ++i)
+            f();
+        auto dt = std::chrono::duration<double, std::nano>(Clock::now() - t0);
+        double n = double(iters);
+        return {name, iters, dt.count() / n, double(alloc_count() - a0) / n,
+                double(alloc_bytes() - b0) / n};
+    }
+
+    Options opts_;
+    std::vector<Result> results_;
+};
+
+/* An index in the middle of size n */
+bigint mid_index(int n) {
+    return (n ? prefixN[n - 1] : bigint(0)) + Wn[n] / 2;
+}
+
+std::string all_true_inputs(const std::vector<int> &labels) {
+    int vars = 0;
+    for (int l : labels)
+        vars = std::max(vars, l + 1);
+    std::string json = "{";
+    for (int v = 0; v < vars; ++v) {
+        if (v)
+            json += ',';
+        json += '"' + Labels[v] + "\":true";
+    }
+    return json + '}';
+}
+
+void run_all(Runner &bench) {
+    /* first touch of the tables: seeded layers, growth past the seed, and
+     * the narrow tiers */
+    bench.once("table_init/seed", [] {
+        for (int n = 0; n <= table_limbs::size(); ++n)
+            keep(size_layer(n));
+    });
+    bench.once("table_init/grow", [] {
+        for (int n = 0; n <= size_limit(); ++n)
+            keep(size_layer(n));
+    });
+    bench.once("table_init/tiers", [] {
+        for (int n = 0; n <= size_limit(); ++n) {
+            keep(tiered::layer<tiered::u64>(n));
+            keep(tiered::layer<tiered::u128>(n));
+            keep(tiered::layer<tiered::u1024>(n));
+        }
+    });
+
+    std::string sig;
+    std::vector<std::uint8_t> ops;
+    std::vector<int> labels;
+    bigint p50 = pow(bigint(10), 50);
+    for (auto [tag, N] : {std::pair<const char *, bigint>{"small", 12345},
+                          {"1e50", p50},
+                          {"near_max", prefixN[size_limit()] - 1}}) {
+        bench.run(std::string("compute_expr_components/") + tag, [&] {
+            compute_expr_components(N, sig, ops, labels);
+            keep(sig);
+        });
+    }
+
+    const int sizes[] = {5, 20, 50, 100, kDefaultSizeLimit};
+    for (int n : sizes) {
+        std::string tag = "/n=" + std::to_string(n);
+        int s = n / 2 + 1, u = n - s + 1;
+        bigint shapeK = C[s][u] / 2, rgsK = Bell[n + 1] / 3;
+        bench.run("unrank_shape" + tag,
+                  [&] { keep(unrank_shape(s, u, shapeK)); });
+        bench.run("unrank_rgs" + tag,
+                  [&] { keep(unrank_rgs(n + 1, rgsK)); });
+
+        bigint opIdx;
+        compute_expr_components(mid_index(n), sig, opIdx, labels);
+        bench.run("emit_expr" + tag,
+                  [&] { keep(emit_expr(sig, opIdx, labels)); });
+        bench.run("emit_expr_both" + tag,
+                  [&] { keep(emit_expr_both(sig, opIdx, labels)); });
+
+        auto tree = emit_expr_both(sig, opIdx, labels).second;
+        bench.run("serialise_tree" + tag,
+                  [&] { keep(serialise_tree(tree.get())); });
+
+        bigint N = mid_index(n);
+        std::string inputs = all_true_inputs(labels);
+        bench.run("evaluate_expr_full_json" + tag,
+                  [&] { keep(evaluate_expr_full_json(N, inputs)); });
+        bench.run("get_expr_full" + tag, [&] { keep(get_expr_full(N)); });
+        std::string text = get_expr(N);
+        bench.run("rank_expr" + tag, [&] { keep(rank_expr(text)); });
+    }
+
+    ExprSampler smp(1);
+    ExprRecord rec;
+    for (int n : sizes)
+        bench.run("sample/n=" + std::to_string(n), [&] {
+            smp.sample({n}, rec);
+            keep(rec);
+        });
+
+    for (int digits : {20, 100, 500, 1000, 5000}) {
+        bigint x = pow(bigint(10), digits) / 7;
+        bench.run("to_string/digits=" + std::to_string(digits),
+                  [&] { keep(to_string(x)); });
+    }
+}
+
+void usage() {
+    std::cerr << "usage: bench_compute [--format json|csv] [-o FILE]"
+                 " [--filter SUBSTR] [--min-time SECONDS]\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return 2;
+        }
+        if (a == "--format")
+            opts.format = argv[++i];
+        else if (a == "-o")
+            opts.out = argv[++i];
+        else if (a == "--filter")
+            opts.filter = argv[++i];
+        else if (a == "--min-time")
+            opts.minTime = std::stod(argv[++i]);
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (opts.format != "json" && opts.format != "csv") {
+        usage();
+        return 2;
+    }
+
+    Runner bench(opts);
+    run_all(bench);
+    if (opts.out.empty()) {
+        bench.report(std::cout);
+    } else {
+        std::ofstream out(opts.out);
+        bench.report(out);
+        if (!out) {
+            std::cerr << "bench_compute: cannot write " << opts.out << '\n';
+            return 1;
+        }
+    }
+    return 0;
+}
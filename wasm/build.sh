@@ -11,4 +11,4 @@ emcmake cmake -G Ninja \
     -DVCPKG_TARGET_TRIPLET=wasm32-emscripten \
     ..
 
-cmake --build . --target wasm_main
+cmake --build . --target wasm_main wasm_main_simd wasm_main_mt
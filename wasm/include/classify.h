@@ -0,0 +1,49 @@
+#ifndef CLASSIFY_H
+#define CLASSIFY_H
+
+#include "parallel.h"
+#include "truth_table.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Boolean-function histogram of an index range (native only).
+ *
+ * Every expression is reduced to its truth table over its labels in RGS
+ * order (A is the first leaf's variable, B the next new one, …), which is
+ * the canonical fingerprint: two expressions compute the same function
+ * exactly when the tables match. Workers aggregate into private hash maps
+ * that are merged into a sharded shared map whenever they reach
+ * localEntries, so per-worker memory stays bounded; the shared map stops
+ * admitting new functions at maxFunctions and counts the rest as
+ * untracked. */
+
+struct ClassifyOptions {
+    EnumerateOptions enumerate;
+    int maxVars = 16;                   // wider expressions are only counted
+    std::size_t maxFunctions = 1 << 22; // distinct functions kept
+    std::size_t localEntries = 1 << 14; // per-worker map size before merging
+};
+
+struct FunctionStats {
+    TruthTable table;
+    std::uint64_t count = 0;
+    bigint first;    // smallest index computing the function
+    int minSize = 0; // size of that index, the smallest one
+};
+
+struct FunctionHistogram {
+    std::vector<FunctionStats> functions; // ordered by first index
+    std::uint64_t expressions = 0;        // every index in the range
+    std::uint64_t wide = 0;      // more than maxVars variables, not classified
+    std::uint64_t untracked = 0; // classified after maxFunctions was reached
+};
+
+/* Classifies [start, end); blocks until done. With more distinct functions
+ * than maxFunctions, which ones are kept depends on scheduling. */
+FunctionHistogram classify_range(const bigint &start, const bigint &end,
+                                 const ClassifyOptions &opts = {});
+/* Every expression of size n */
+FunctionHistogram classify_size(int n, const ClassifyOptions &opts = {});
+
+#endif // CLASSIFY_H
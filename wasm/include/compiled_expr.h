@@ -0,0 +1,62 @@
+#ifndef COMPILED_EXPR_H
+#define COMPILED_EXPR_H
+
+#include "compute.h"
+#include "flat_expr.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* An expression unranked once and kept for repeated evaluation.
+ *
+ * Inputs and outputs are bit vectors in 32-bit words: variable i (label
+ * order, A = 0) is bit i % 32 of mask[i / 32], and node i (preorder, the
+ * n<i> ids of evaluate_expr_full_json) is bit i % 32 of the node word
+ * vector.
+ *
+ * The handle also keeps the last per-node values, so flip() can update
+ * them after a single input changes: only ancestors of that variable's
+ * leaves are revisited, and propagation stops at any node whose value
+ * stays the same. */
+class CompiledExpr {
+  public:
+    explicit CompiledExpr(const bigint &N);
+    /* From an already decoded expression (e.g. an ExprCache entry) */
+    explicit CompiledExpr(const ExprRecord &r);
+
+    int vars() const { return flat_.vars; }
+    std::size_t nodes() const { return flat_.nodes.size(); }
+    /* words a mask needs: one per 32 variables */
+    std::size_t mask_words() const { return (flat_.vars + 31) / 32; }
+    const FlatExpr &flat() const { return flat_; }
+
+    /* Root value; mask must hold mask_words() words */
+    bool eval(const std::uint32_t *mask);
+    /* Per-node values (bit 0 of word 0 is the root); valid until the next
+     * call */
+    const std::vector<std::uint32_t> &eval_nodes(const std::uint32_t *mask);
+
+    /* Current state (all inputs 0 until the first eval) */
+    bool input(int v) const { return inputs_[v]; }
+    bool value(std::size_t node) const { return values_[node]; }
+
+    /* Toggles variable v and re-evaluates incrementally. Returns the
+     * preorder ids whose value changed, children before parents; valid
+     * until the next call. */
+    const std::vector<std::uint32_t> &flip(int v);
+
+  private:
+    void build(); // evaluation state for flat_
+    void load(const std::uint32_t *mask);
+
+    FlatExpr flat_;
+    std::vector<std::uint8_t> inputs_, values_;
+    std::vector<std::uint32_t> nodeBits_;
+
+    std::vector<std::uint32_t> parent_;              // root: kNoParent
+    std::vector<std::uint32_t> leafStart_, leafIds_; // leaves of var v
+    std::vector<std::uint32_t> dirty_, changed_;     // flip() scratch
+    std::vector<std::uint8_t> queued_;
+};
+
+#endif // COMPILED_EXPR_H
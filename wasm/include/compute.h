@@ -2,6 +2,7 @@
 #define COMPUTE_H
 
 #include <boost/multiprecision/cpp_int.hpp>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -14,19 +15,42 @@ struct ExprTree {
     std::unique_ptr<ExprTree> left;
     std::unique_ptr<ExprTree> right;
 };
+/* Compact form of one expression: shape signature, one operator digit per
+ * binary node (0/1/2 = AND/OR/XOR, preorder) and the leaf labels as a
+ * restricted growth string */
+struct ExprRecord {
+    std::string sig;
+    std::vector<std::uint8_t> ops;
+    std::vector<int> labels;
+};
+
 std::string evaluate_expr_full_json(bigint N, const std::string &jsonInputs);
 std::string to_string(bigint x);
 std::vector<int> unrank_rgs(int len, bigint k);
 std::string unrank_shape(int s, int u, bigint k);
+std::vector<std::uint8_t> decode_ops(const std::string &sig, bigint opIdx);
 std::string emit_expr(const std::string &sig, bigint opIdx,
                       const std::vector<int> &lbl);
+std::string emit_expr(const std::string &sig,
+                      const std::vector<std::uint8_t> &ops,
+                      const std::vector<int> &lbl);
 
 void compute_expr_components(bigint n, std::string &sig, bigint &opIdx,
                              std::vector<int> &labels);
+void compute_expr_components(bigint n, std::string &sig,
+                             std::vector<std::uint8_t> &ops,
+                             std::vector<int> &labels);
 std::pair<std::string, std::unique_ptr<ExprTree>>
 emit_expr_both(const std::string &sig, bigint opIdx,
                const std::vector<int> &labels);
 std::string serialise_tree(const ExprTree *node);
 std::string get_expr(bigint n);
 std::string get_expr_full(bigint n);
+
+bigint rank_rgs(const std::vector<int> &labels);
+bigint rank_shape(const std::string &sig);
+bigint rank_expr_components(const std::string &sig, const bigint &opIdx,
+                            const std::vector<int> &labels);
+bigint rank_expr(const std::string &expr);
+bigint rank_tree(const ExprTree *tree);
 #endif // COMPUTE_H
@@ -1,111 +1,203 @@
 #ifndef COMPUTE_DATA_H
 #define COMPUTE_DATA_H
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #include <boost/multiprecision/cpp_int.hpp>
 using bigint = boost::multiprecision::cpp_int;
 
-constexpr int MAX_S = 100;
-constexpr int MAX_U = 100;
-constexpr int MAX_N = MAX_S - 1 + MAX_U;
-constexpr std::size_t kMaxLabels = MAX_S * 2;
+/* Size limits. The tables are grown one total size n at a time, on first
+ * use, up to size_limit(). Sizes covered by the build-time tables
+ * (tools/gen_tables.py) cost no arithmetic; larger ones are computed. */
+constexpr int kDefaultSizeLimit = 199; // the former MAX_S = MAX_U = 100 range
+/* Sizes 0…kStableSize are numbered exactly as under the former fixed
+ * 100x100 tables; from prefixN[kStableSize] on, the complete sizes above
+ * give every index a different expression */
+constexpr int kStableSize = 99;
+/* Highest limit set_size_limit() accepts. Table memory grows about as n³
+ * (measured, x86-64: 12 MB at 199, 180 MB at 600, 825 MB at 1000,
+ * 1.4 GB at 1200, ~2.8 GB at 1500), so the cap is what each platform can
+ * hold: the WebAssembly heap stops at 2 GB (MAXIMUM_MEMORY), which also
+ * has to fit the split tables and everything else in the module. */
+#ifdef __EMSCRIPTEN__
+constexpr int kMaxSizeLimit = 1000;
+#else
+constexpr int kMaxSizeLimit = 1500;
+#endif
 
-/* 3^k table – operator choices per binary node */
-inline const auto Pow3 = [] {
-    std::array<bigint, MAX_S + 1> a{};
-    a[0] = 1;
-    for (int i = 1; i <= MAX_S; ++i)
-        a[i] = a[i - 1] * 3;
-    return a;
-}();
+int size_limit();
+/* Raises or lowers the limit; sizes that are already built stay usable */
+void set_size_limit(int n);
 
-/* Bell numbers – |set partitions| of the leaves */
-inline const auto Bell = [] {
-    std::array<bigint, MAX_S + 1> b{}, prev{}, cur{};
-    prev[0] = b[0] = 1;
-    for (int n = 1; n <= MAX_S; ++n) {
-        cur[0] = prev[n - 1];
-        for (int k = 1; k <= n; ++k)
-            cur[k] = cur[k - 1] + prev[k - 1];
-        b[n] = cur[0];
-        prev = cur;
-    }
-    return b;
-}();
+/* Everything the enumeration needs that first appears at total size n:
+ *   Pow3    = 3^n
+ *   Bell    = Bell[n + 1]
+ *   C[i]    = C[i + 1][n - i]       (the s + u = n + 1 diagonal)
+ *   DP_RGS[l] = DP_RGS[l][n + 1 - l] (the len + max = n + 1 diagonal)
+ *   Wn, prefixN for size n
+ * and products derived from them when the layer is built:
+ *   ShapeSpan     = Pow3·Bell, the indices per shape with s = n + 1 leaves
+ *   BlockStart[j] = offset of the s = j + 1 block within size n, for
+ *                   j = 0…n+1 (so BlockStart[n + 1] = Wn)
+ *   RGSReuse[l]   = (m + 1)·DP_RGS[l] with m = n + 1 - l, the RGS
+ *                   continuations whose next label is one already used */
+template <class Int> struct SizeLayer {
+    Int Pow3, Bell, Wn, prefixN, ShapeSpan;
+    std::vector<Int> C, DP_RGS, BlockStart, RGSReuse;
+};
 
-/* C[s][u] – number of shapes with s leaves, u unary nodes */
-inline const auto C = [] {
-    std::array<std::array<bigint, MAX_U + 1>, MAX_S + 1> c{};
-    c[1][0] = 1;
-    for (int s = 1; s <= MAX_S; ++s)
-        for (int u = 1; u <= MAX_U; ++u)
-            c[s][u] = c[s][u - 1];
-    for (int s = 2; s <= MAX_S; ++s)
-        for (int u = 0; u <= MAX_U; ++u)
-            for (int ls = 1; ls < s; ++ls) {
-                int rs = s - ls;
-                for (int u1 = 0; u1 <= u; ++u1)
-                    c[s][u] += c[ls][u1] * c[rs][u - u1];
-            }
-    return c;
-}();
+/* Append-only per-size storage. Layer n is built once, after layers
+ * 0…n-1, and never moves, so readers only need an acquire load. */
+template <class Layer> class Layers {
+  public:
+    using Builder = void (*)(int n, Layer &out);
 
-/* DP_RGS –  table for restricted growth strings */
-inline const auto DP_RGS = [] {
-    std::array<std::array<bigint, MAX_S + 2>, MAX_S + 2> dp{};
-    for (int m = 0; m <= MAX_S + 1; ++m)
-        dp[0][m] = 1;
-    for (int len = 1; len <= MAX_S; ++len)
-        for (int max = MAX_S; max >= 0; --max) {
-            bigint s = 0;
-            for (int v = 0; v <= max + 1; ++v)
-                s += dp[len - 1][std::max(max, v)];
-            dp[len][max] = s;
-        }
-    return dp;
-}();
+    constexpr explicit Layers(Builder build) : build_(build) {}
 
-/* Wn / prefixN – weight per total size n  = Σ C[s][u]·3^(s-1)·Bell[s] */
-inline const auto size_pair = [] {
-    std::array<bigint, MAX_N + 1> W{}, P{};
-    for (int n = 0; n <= MAX_N; ++n) {
-        bigint w = 0;
-        for (int u = 0; u <= n && u <= MAX_U; ++u) {
-            int s = n - u + 1, b = n - u;
-            if (s < 1 || s > MAX_S)
-                continue;
-            w += C[s][u] * Pow3[b] * Bell[s];
+    const Layer &at(int n) {
+        if (n < 0 || n > kMaxSizeLimit)
+            throw std::runtime_error("Size out of range: " +
+                                     std::to_string(n));
+        if (const Layer *l = slots_[n].load(std::memory_order_acquire))
+            return *l;
+        return grow(n);
+    }
+
+    int built() const { return built_.load(std::memory_order_acquire); }
+
+  private:
+    const Layer &grow(int n) {
+        std::lock_guard lock(mu_);
+        for (int k = built(); k <= n; ++k) {
+            if (k > size_limit())
+                throw std::runtime_error(
+                    "Size " + std::to_string(k) + " exceeds the size limit (" +
+                    std::to_string(size_limit()) + ")");
+            auto layer = std::make_unique<Layer>();
+            build_(k, *layer);
+            slots_[k].store(layer.get(), std::memory_order_release);
+            owned_.push_back(std::move(layer));
+            built_.store(k + 1, std::memory_order_release);
         }
-        W[n] = w;
-        P[n] = (n ? P[n - 1] : 0) + w;
+        return *slots_[n].load(std::memory_order_relaxed);
     }
-    return std::pair{W, P};
-}();
 
-inline const auto &Wn = size_pair.first;
-inline const auto &prefixN = size_pair.second;
+    Builder build_;
+    std::array<std::atomic<const Layer *>, kMaxSizeLimit + 1> slots_{};
+    std::mutex mu_;
+    std::atomic<int> built_{0}; // written under mu_
+    std::vector<std::unique_ptr<Layer>> owned_;
+};
+
+/* The bigint layer for size n, growing the tables if needed */
+const SizeLayer<bigint> &size_layer(int n);
+/* Number of bigint layers built so far (sizes 0…built_sizes()-1) */
+int built_sizes();
 
-inline const auto Labels = [] {
-    constexpr std::size_t MaxLen = 8;
-    using buf_t = std::array<char, MaxLen>;
+/* Raw generated entries for sizes up to table_limbs::size(), for tiers
+ * that narrow without going via bigint */
+struct LimbSpan {
+    const std::uint64_t *limbs; // little-endian 64-bit limbs
+    std::uint32_t len;          // 0 means zero
+};
 
-    std::array<std::string, kMaxLabels> tbl{};
+namespace table_limbs {
+int size();
+LimbSpan Pow3(int n);
+LimbSpan Bell(int n); // Bell[n + 1]
+LimbSpan C(int n, int i);
+LimbSpan DP_RGS(int n, int l);
+LimbSpan Wn(int n);
+LimbSpan prefixN(int n);
+} // namespace table_limbs
 
-    for (std::size_t i = 0; i < kMaxLabels; ++i) {
-        buf_t buf{};
-        std::size_t pos = MaxLen;
-        std::uint64_t id = i;
+/* Array-style views: Pow3[k], Bell[s], C[s][u], DP_RGS[len][max], Wn[n],
+ * prefixN[n] and Labels[i] grow the tables to the size they need */
+namespace table_view {
 
-        do {
-            buf[--pos] = static_cast<char>('A' + id % 26);
-            id /= 26;
-            if (id == 0)
-                break;
-            --id;
-        } while (true);
+inline const bigint &zero() {
+    static const bigint z = 0;
+    return z;
+}
+inline const bigint &one() {
+    static const bigint o = 1;
+    return o;
+}
 
-        tbl[i] = std::string(buf.data() + pos, MaxLen - pos);
+struct Pow3Ref {
+    const bigint &operator[](int k) const { return size_layer(k).Pow3; }
+};
+struct BellRef {
+    const bigint &operator[](int s) const {
+        return s ? size_layer(s - 1).Bell : one();
     }
-    return tbl;
-}();
+};
+struct CRow {
+    int s;
+    const bigint &operator[](int u) const {
+        return s ? size_layer(s - 1 + u).C[s - 1] : zero();
+    }
+};
+struct CRef {
+    CRow operator[](int s) const { return {s}; }
+};
+struct DPRow {
+    int len;
+    const bigint &operator[](int max) const {
+        return len + max ? size_layer(len + max - 1).DP_RGS[len] : one();
+    }
+};
+struct DPRef {
+    DPRow operator[](int len) const { return {len}; }
+};
+struct WnRef {
+    const bigint &operator[](int n) const { return size_layer(n).Wn; }
+};
+struct PrefixRef {
+    const bigint &operator[](int n) const { return size_layer(n).prefixN; }
+};
+struct ShapeSpanRef {
+    const bigint &operator[](int s) const { return size_layer(s - 1).ShapeSpan; }
+};
+struct BlockRow {
+    int n;
+    const bigint &operator[](int s) const {
+        return size_layer(n).BlockStart[s - 1];
+    }
+};
+struct BlockRef {
+    BlockRow operator[](int n) const { return {n}; }
+};
+
+const std::string &label(int i);
+struct LabelRef {
+    const std::string &operator[](std::size_t i) const { return label(int(i)); }
+};
+
+} // namespace table_view
+
+/* 3^k table – operator choices per binary node */
+inline constexpr table_view::Pow3Ref Pow3{};
+/* Bell numbers – |set partitions| of the leaves */
+inline constexpr table_view::BellRef Bell{};
+/* C[s][u] – number of shapes with s leaves, u unary nodes */
+inline constexpr table_view::CRef C{};
+/* DP_RGS –  table for restricted growth strings */
+inline constexpr table_view::DPRef DP_RGS{};
+/* Wn / prefixN – weight per total size n  = Σ C[s][u]·3^(s-1)·Bell[s] */
+inline constexpr table_view::WnRef Wn{};
+inline constexpr table_view::PrefixRef prefixN{};
+/* ShapeSpan[s] = 3^(s-1)·Bell[s]; BlockStart[n][s] = offset of the s-leaf
+ * block within size n */
+inline constexpr table_view::ShapeSpanRef ShapeSpan{};
+inline constexpr table_view::BlockRef BlockStart{};
+/* Bijective base-26 variable names */
+inline constexpr table_view::LabelRef Labels{};
+
 #endif
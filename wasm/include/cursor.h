@@ -0,0 +1,67 @@
+#ifndef CURSOR_H
+#define CURSOR_H
+
+#include "compute.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Stateful walker over consecutive indices N, N+1, …
+ *
+ * Keeps the decoded (shape, operator digits, RGS) triple and steps it in
+ * index order: RGS first, then operator digits, then shape, then block.
+ * next() is amortized O(1) and performs no bigint division. prev() steps
+ * RGS and operator digits back in place too, but re-unranks when it
+ * crosses into the previous shape. */
+class ExprCursor {
+  public:
+    explicit ExprCursor(const bigint &N = 0);
+
+    /* Repositions on N with a full unrank */
+    void seek(const bigint &N);
+    /* Steps to N+1; returns false (and stays put) at the last index
+     * within size_limit() */
+    bool next();
+    /* Steps to N-1; returns false (and stays put) at index 0 */
+    bool prev();
+    /* Steps to N+delta, reusing the decoded shape when it stays the same */
+    bool advance(const bigint &delta);
+
+    const bigint &index() const { return N_; }
+    int size() const { return n_; }
+    int leaves() const { return s_; }
+    int unary() const { return u_; }
+    const std::string &signature() const { return sig_; }
+    /* operator digit per binary node in preorder (0=AND, 1=OR, 2=XOR) */
+    const std::vector<std::uint8_t> &ops() const { return ops_; }
+    const std::vector<int> &labels() const { return rgs_; }
+    std::string expr() const { return emit_expr(sig_, ops_, rgs_); }
+
+  private:
+    bool next_rgs();
+    bool next_ops();
+    bool prev_rgs();
+    bool prev_ops();
+    bool next_shape();
+    bool next_shape_at(char *p, int s, int u);
+    const std::string &last_shape(int s, int u);
+    void enter_block(int n, int u);
+    void decode_local(const bigint &local);
+
+    bigint N_;
+    bigint shapeBase_, shapeSpan_; // first index / count for current shape
+    int n_ = 0, s_ = 1, u_ = 0;
+    std::string sig_;
+    std::vector<std::uint8_t> ops_;
+    std::vector<int> rgs_, rgsMax_; // rgsMax_[i] = max(rgs_[0..i])
+    std::vector<std::string> lastShape_; // per (s, u), grown on demand
+};
+
+/* Batch forms of get_expr / get_expr_full for start … start+count-1,
+ * decoded with one cursor. Stop early at the end of the enumeration. */
+/* expressions separated by '\n' */
+std::string get_expr_range(const bigint &start, std::size_t count);
+/* JSON array of {"expr":…,"tree":…} objects */
+std::string get_expr_range_full(const bigint &start, std::size_t count);
+
+#endif // CURSOR_H
@@ -0,0 +1,28 @@
+#ifndef DECIMAL_H
+#define DECIMAL_H
+
+#include "compute.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* Decimal and byte conversions for indices.
+ *
+ * Both decimal directions split the number at a cached power 10^(19·2^k):
+ * parsing joins halves with one multiplication (Karatsuba inside cpp_int),
+ * printing splits them with a Barrett division, i.e. two multiplications
+ * against a cached reciprocal. Pieces below a few dozen 64-bit limbs are
+ * converted on a plain limb array, 19 digits per step. */
+
+/* Parses [-]digits; throws std::runtime_error on anything else */
+bigint from_decimal(std::string_view s);
+std::string to_decimal(const bigint &x);
+
+/* Little-endian magnitude bytes, as used by the JS BigInt helpers; zero is
+ * the empty array. to_le_bytes throws for negative values. */
+std::vector<std::uint8_t> to_le_bytes(const bigint &x);
+bigint from_le_bytes(const std::uint8_t *bytes, std::size_t n);
+
+#endif // DECIMAL_H
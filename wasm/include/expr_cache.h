@@ -0,0 +1,72 @@
+#ifndef EXPR_CACHE_H
+#define EXPR_CACHE_H
+
+#include "compute.h"
+#include "cursor.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+
+/* Bounded LRU cache of decoded expressions, keyed by index.
+ *
+ * Entries hold the compact (shape, operator digits, labels) triple, from
+ * which any output form is emitted. After each lookup the neighbours
+ * N-k … N+k that are missing are decoded by stepping one ExprCursor with
+ * prev() / next() from N, so browsing to an adjacent index is a hit and
+ * costs no unranking. Entries are evicted least recently used first once
+ * either the entry count or the estimated byte total is over budget; the
+ * entry just looked up is never evicted. */
+
+struct ExprCacheOptions {
+    std::size_t capacity = 256;      // entries
+    std::size_t maxBytes = 4 << 20;  // estimated heap use of the entries
+    unsigned prefetch = 4;           // k
+};
+
+struct ExprCacheStats {
+    std::uint64_t hits = 0, misses = 0;
+    std::uint64_t prefetched = 0; // entries decoded ahead of a lookup
+    std::uint64_t evictions = 0;
+};
+
+class ExprCache {
+  public:
+    explicit ExprCache(const ExprCacheOptions &opts = {});
+
+    /* Decoded expression N; valid until the next call. Throws like
+     * compute_expr_components for indices out of range. */
+    const ExprRecord &get(const bigint &N);
+    bool contains(const bigint &N) const { return index_.count(N) != 0; }
+
+    /* New limits apply at once (evicting as needed) */
+    void configure(const ExprCacheOptions &opts);
+    const ExprCacheOptions &options() const { return opts_; }
+    void clear();
+
+    std::size_t size() const { return lru_.size(); }
+    std::size_t bytes() const { return bytes_; }
+    const ExprCacheStats &stats() const { return stats_; }
+
+  private:
+    struct Entry {
+        bigint N;
+        ExprRecord rec;
+        std::size_t bytes;
+    };
+    using List = std::list<Entry>;
+
+    void place(const bigint &N);
+    void insert(List::iterator where);
+    void prefetch(const bigint &N);
+    void evict();
+
+    ExprCacheOptions opts_;
+    ExprCacheStats stats_;
+    List lru_; // most recent first
+    std::map<bigint, List::iterator> index_;
+    std::size_t bytes_ = 0;
+    ExprCursor cursor_;
+};
+
+#endif // EXPR_CACHE_H
@@ -0,0 +1,55 @@
+#ifndef FLAT_EXPR_H
+#define FLAT_EXPR_H
+
+#include "compute.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class NodeOp : std::uint8_t { Var, Not, And, Or, Xor };
+
+/* One preorder node. A unary/binary node's left child is the next entry;
+ * a binary node's right child sits `right` entries further on. */
+struct FlatNode {
+    NodeOp op;
+    std::uint16_t label; // Var only
+    std::uint32_t right; // And/Or/Xor only
+};
+
+/* Contiguous preorder expression. Meant to be reused: rebuilding into the
+ * same FlatExpr keeps its capacity, so bulk generation stops allocating
+ * once the largest expression has been seen. */
+struct FlatExpr {
+    std::vector<FlatNode> nodes;
+    int vars = 0; // distinct labels
+    std::vector<std::uint32_t> work; // scratch stack for the passes below
+};
+
+void flatten_expr(const std::string &sig,
+                  const std::vector<std::uint8_t> &ops,
+                  const std::vector<int> &labels, FlatExpr &out);
+
+/* Column form of a FlatExpr for zero-copy export (e.g. as JS typed-array
+ * views): per preorder node one NodeOp byte and one label id (Var nodes;
+ * 0 otherwise). Children are implied by preorder and each op's arity. */
+struct PackedTree {
+    std::vector<std::uint8_t> ops;
+    std::vector<std::uint16_t> labels;
+};
+
+/* Refills `out` (capacity is kept) */
+void pack_flat(const FlatExpr &e, PackedTree &out);
+
+/* Appends AND(…)/OR(…)/XOR(…)/NOT(…) text */
+void emit_flat(FlatExpr &e, std::string &out);
+/* Appends the same JSON as serialise_tree */
+void serialise_flat(FlatExpr &e, std::string &out);
+/* Fills values[i] for every node i given one 0/1 byte per label id;
+ * returns the root value */
+bool evaluate_flat(const FlatExpr &e, const std::uint8_t *inputs,
+                   std::vector<std::uint8_t> &values);
+/* ExprTree adapter for callers of the pointer-based API */
+std::unique_ptr<ExprTree> to_tree(const FlatExpr &e);
+
+#endif // FLAT_EXPR_H
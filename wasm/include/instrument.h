@@ -0,0 +1,110 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+/* Optional hot-path instrumentation.
+ *
+ * Configure with -DCIRCFINITY_INSTRUMENT=ON to record, per phase, call
+ * counts, wall time and heap allocations (operator new is replaced in
+ * that build), plus bigint operation and tree node counters. Phase times
+ * are inclusive: a phase entered inside another counts towards both.
+ * With tracing switched on every phase entry is also kept as a Chrome
+ * trace event (chrome://tracing, Perfetto).
+ *
+ * In the default build CIRC_PHASE / CIRC_COUNT expand to nothing and the
+ * query functions report `"enabled":false` with zero counts. */
+
+#ifndef CIRCFINITY_INSTRUMENT
+#define CIRCFINITY_INSTRUMENT 0
+#endif
+
+namespace instrument {
+
+constexpr bool kEnabled = CIRCFINITY_INSTRUMENT != 0;
+
+enum class Phase : std::uint8_t {
+    SizeSearch,  // prefixN search for the expression size
+    BlockScan,   // (s, u) block selection within the size
+    UnrankShape, // shape signature
+    UnrankRgs,   // label partition
+    DecodeOps,   // operator digits
+    BuildTree,   // ExprTree allocation
+    EmitText,    // expression string
+    EmitJson,    // tree / evaluation JSON
+    ParseInputs, // evaluation input JSON
+    Evaluate,    // node values
+    Count
+};
+
+enum class Counter : std::uint8_t {
+    BigintOps, // cpp_int arithmetic and comparisons in the unrankers
+    TreeNodes, // ExprTree nodes allocated
+    Count
+};
+
+constexpr std::size_t kPhases = std::size_t(Phase::Count);
+constexpr std::size_t kCounters = std::size_t(Counter::Count);
+/* Trace events kept before further ones are dropped */
+constexpr std::size_t kMaxTraceEvents = 1 << 16;
+
+const char *name(Phase p);
+const char *name(Counter c);
+
+struct PhaseStats {
+    std::uint64_t calls = 0, ns = 0, allocs = 0;
+};
+
+struct Stats {
+    std::array<PhaseStats, kPhases> phases{};
+    std::array<std::uint64_t, kCounters> counters{};
+    std::uint64_t allocs = 0, allocBytes = 0; // whole process
+};
+
+Stats snapshot();
+/* Clears counters and recorded trace events */
+void reset();
+/* {"enabled":…,"phases":{name:{calls,ns,allocs}},"counters":{…},…} */
+std::string stats_json();
+
+void set_tracing(bool on);
+/* {"traceEvents":[{"name","ph":"X","ts","dur","pid","tid"},…]} */
+std::string trace_json();
+
+#if CIRCFINITY_INSTRUMENT
+
+/* Times one phase entry (RAII) */
+class Scope {
+  public:
+    explicit Scope(Phase p);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    Phase phase_;
+    std::uint64_t t0_, allocs0_;
+};
+
+void add(Counter c, std::uint64_t n);
+
+#define CIRC_CAT_(a, b) a##b
+#define CIRC_CAT(a, b) CIRC_CAT_(a, b)
+#define CIRC_PHASE(p)                                                          \
+    ::instrument::Scope CIRC_CAT(circScope, __LINE__) {                        \
+        ::instrument::Phase::p                                                 \
+    }
+#define CIRC_COUNT(c, n) ::instrument::add(::instrument::Counter::c, (n))
+
+#else
+
+#define CIRC_PHASE(p) ((void)0)
+#define CIRC_COUNT(c, n) ((void)0)
+
+#endif
+
+} // namespace instrument
+
+#endif // INSTRUMENT_H
@@ -0,0 +1,36 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/* Word-parallel inner loops shared by the evaluation and decoding paths.
+ *
+ * Each kernel has explicit 128-bit WebAssembly SIMD (built with
+ * -msimd128), x86 AVX2 (-mavx2, CIRCFINITY_AVX2=ON) and portable scalar
+ * forms; the one matching the target is picked at compile time and all
+ * three give identical results. Pointers may alias only where noted. */
+
+namespace kernels {
+
+/* "simd128", "avx2" or "scalar" */
+const char *backend();
+
+/* r[i] op= a[i] for i < n (r may equal a) */
+void and_words(std::uint64_t *r, const std::uint64_t *a, std::size_t n);
+void or_words(std::uint64_t *r, const std::uint64_t *a, std::size_t n);
+void xor_words(std::uint64_t *r, const std::uint64_t *a, std::size_t n);
+void not_words(std::uint64_t *r, std::size_t n);
+
+/* The n <= 40 lowest base-3 digits of x < 3^40, least significant first */
+void base3_digits(std::uint64_t x, std::uint8_t *out, std::size_t n);
+
+/* out[i] = bit i of the little-endian bit vector (0 or 1), i < n */
+void unpack_bits(const std::uint32_t *bits, std::uint8_t *out, std::size_t n);
+/* Inverse: packs n bytes (0 or 1) into (n + 31) / 32 words, clearing the
+ * unused high bits of the last one */
+void pack_bits(const std::uint8_t *in, std::uint32_t *bits, std::size_t n);
+
+} // namespace kernels
+
+#endif // KERNELS_H
@@ -0,0 +1,60 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "cursor.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+/* Native parallel enumeration of an index range.
+ *
+ * [start, end) is cut into chunks of similar cost (indices weighted by
+ * expression size via prefixN), the chunks are dealt out to per-worker
+ * deques, and idle workers steal from the far end of a busy worker's
+ * deque. The workers belong to one process-wide pool, started on first
+ * use and kept until exit; each owns its deque and one ExprCursor, and
+ * only re-seeks when its next chunk does not follow the previous one. */
+
+struct RangeChunk {
+    bigint begin, end;
+};
+
+struct EnumerateOptions {
+    unsigned threads = 0;          // 0 = std::thread::hardware_concurrency()
+    unsigned chunksPerThread = 16; // more chunks = finer stealing
+};
+
+/* Cuts [start, end) into at most `parts` contiguous chunks of similar
+ * total expression size */
+std::vector<RangeChunk> split_range(const bigint &start, const bigint &end,
+                                    std::size_t parts);
+
+/* Called once per chunk with the worker's cursor on chunk.begin; the sink
+ * walks the chunk itself (cursor.next() up to chunk.end - 1) */
+using ChunkSink =
+    std::function<void(const RangeChunk &, ExprCursor &, unsigned worker)>;
+/* Called for every index, in ascending order within a chunk */
+using IndexVisitor = std::function<void(const ExprCursor &, unsigned worker)>;
+
+/* Both block until the range is done. Callbacks run concurrently on
+ * different workers (worker < threads); the first exception thrown stops
+ * the remaining chunks and is rethrown here. Calls from different threads
+ * take turns on the pool; a call from inside a callback runs on the
+ * calling worker alone. */
+void enumerate_chunks(const bigint &start, const bigint &end,
+                      const ChunkSink &sink,
+                      const EnumerateOptions &opts = {});
+void enumerate_range(const bigint &start, const bigint &end,
+                     const IndexVisitor &visit,
+                     const EnumerateOptions &opts = {});
+
+/* get_expr_range / get_expr_range_full with the chunks decoded on
+ * workers; the output is identical to the sequential forms */
+std::string get_expr_range_parallel(const bigint &start, std::size_t count,
+                                    const EnumerateOptions &opts = {});
+std::string get_expr_range_full_parallel(const bigint &start,
+                                         std::size_t count,
+                                         const EnumerateOptions &opts = {});
+
+#endif // PARALLEL_H
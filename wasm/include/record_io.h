@@ -0,0 +1,97 @@
+#ifndef RECORD_IO_H
+#define RECORD_IO_H
+
+#include "compute.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Compact binary dump of consecutive expressions.
+ *
+ * File layout (all integers little-endian):
+ *   header   "CIRCFREC", u32 version, u32 flags, u32 stride,
+ *            u32 n, n bytes: magnitude of the first record's index
+ *   records  one per index, self-delimiting:
+ *              shape bits  preorder, L = 0, U = 10, B = 11 (LSB first)
+ *              op codes    2 bits per binary node, 0/1/2 = AND/OR/XOR
+ *              labels      one byte per leaf (two with kWideLabels)
+ *            each section padded to a whole byte
+ *   index    u64 file offset of every stride-th record
+ *   footer   u64 record count, u64 index offset, "CIRCFEND"
+ *
+ * The sparse index lets a reader seek to record k by jumping to record
+ * k - k % stride and skipping forward. */
+
+constexpr std::uint32_t kRecordVersion = 1;
+constexpr std::uint32_t kWideLabels = 1; // flag: 16-bit labels
+constexpr std::uint32_t kRecordStride = 1024;
+
+/* Buffered writer to a file descriptor (stdout works: nothing is
+ * rewritten, the index goes after the records) */
+class RecordWriter {
+  public:
+    /* maxSize: largest expression size that will be appended; picks the
+     * label width */
+    RecordWriter(int fd, const bigint &start, int maxSize,
+                 std::size_t bufferBytes = 1 << 20);
+    ~RecordWriter();
+    RecordWriter(const RecordWriter &) = delete;
+    RecordWriter &operator=(const RecordWriter &) = delete;
+
+    void append(const std::string &sig, const std::vector<std::uint8_t> &ops,
+                const std::vector<int> &labels);
+    /* Writes the index and footer and flushes; append() is invalid after */
+    void finish();
+
+    std::uint64_t count() const { return count_; }
+
+  private:
+    void flush();
+
+    int fd_;
+    bool wide_, finished_ = false;
+    std::vector<char> buf_;
+    std::size_t used_ = 0;
+    std::uint64_t offset_ = 0, count_ = 0; // bytes written, records
+    std::vector<std::uint64_t> index_;
+};
+
+/* Read-only mmap view of a record file */
+class RecordReader {
+  public:
+    explicit RecordReader(const std::string &path);
+    ~RecordReader();
+    RecordReader(const RecordReader &) = delete;
+    RecordReader &operator=(const RecordReader &) = delete;
+
+    std::uint64_t size() const { return count_; }
+    /* index of record 0 */
+    const bigint &start() const { return start_; }
+
+    /* Positions the cursor on record k */
+    void seek(std::uint64_t k);
+    /* Decodes the record under the cursor and moves past it; false at
+     * the end */
+    bool next(ExprRecord &out);
+    /* seek(k) + next() */
+    ExprRecord read(std::uint64_t k);
+
+  private:
+    /* data_[off]; throws past the records so a corrupt record cannot run
+     * into the index or off the mapping */
+    unsigned char byte(std::size_t off) const;
+    std::size_t skip(std::size_t off) const;
+    std::size_t decode(std::size_t off, ExprRecord &out) const;
+
+    const unsigned char *data_ = nullptr;
+    std::size_t len_ = 0;
+    bool wide_ = false;
+    std::uint32_t stride_ = 0;
+    bigint start_;
+    std::uint64_t count_ = 0, pos_ = 0;
+    std::size_t at_ = 0, recordsEnd_ = 0;
+    const unsigned char *index_ = nullptr;
+};
+
+#endif // RECORD_IO_H
@@ -0,0 +1,65 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include "compute.h"
+#include "flat_expr.h"
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+/* Seeded uniform sampling of expressions.
+ *
+ * A draw picks the size and (s, u) block by weight from prefixN and the
+ * block offsets, then draws the shape rank below C[s][u], one operator
+ * digit per binary node and the label rank below Bell[s] independently.
+ * No index over the whole space is formed or unranked. The generator is
+ * mt19937_64 with its own bounded draws, so a seed gives the same
+ * expressions on every platform. */
+
+/* Domain of a draw: n < 0 means every expression up to size_limit(),
+ * otherwise size n; s > 0 narrows size n to the block with s leaves (and
+ * u = n - s + 1 unary nodes) */
+struct SampleSpec {
+    int n = -1;
+    int s = 0;
+};
+
+/* Many expressions in one node arena: expression i is
+ * nodes[start[i]] … nodes[start[i + 1] - 1] in FlatExpr preorder form
+ * (right offsets are relative, so each slice stands alone) */
+struct FlatBatch {
+    std::vector<FlatNode> nodes;
+    std::vector<std::uint32_t> start; // size() + 1 entries
+    std::vector<int> vars;
+
+    std::size_t size() const { return vars.size(); }
+};
+
+class ExprSampler {
+  public:
+    explicit ExprSampler(std::uint64_t seed);
+
+    /* One draw into `out` (capacity is kept). Throws std::runtime_error
+     * for sizes beyond size_limit() or a leaf count outside 1…n+1. */
+    void sample(const SampleSpec &spec, ExprRecord &out);
+    /* `count` draws into compact records, reusing existing entries */
+    void sample_batch(const SampleSpec &spec, std::size_t count,
+                      std::vector<ExprRecord> &out);
+    /* `count` draws appended to one node arena (cleared first) */
+    void sample_batch(const SampleSpec &spec, std::size_t count,
+                      FlatBatch &out);
+
+    /* Uniform in [0, bound), bound > 0 */
+    bigint below(const bigint &bound);
+
+  private:
+    void sample_block(int s, int u, ExprRecord &out);
+
+    std::mt19937_64 rng_;
+    std::vector<std::uint64_t> words_; // scratch for wide draws
+    ExprRecord scratch_;
+    FlatExpr flat_;
+};
+
+#endif // SAMPLER_H
@@ -0,0 +1,39 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "truth_table.h"
+#include <cstdint>
+#include <optional>
+
+/* Smallest index computing a given Boolean function.
+ *
+ * Sizes are walked in prefixN order and, within a size, blocks, shapes,
+ * operator digits and labels in index order, so the first hit is the
+ * minimum. Candidates are pruned with the sets of functions each size can
+ * reach (with any labels), built bottom-up the way exact synthesis does:
+ * a size is skipped unless the target is reachable at exactly that size,
+ * a shape unless its own reachable set holds the target, and an operator
+ * prefix unless some completion still does. Only the survivors have
+ * their restricted growth labelings evaluated, on packed truth tables.
+ *
+ * The target's variable count is part of the function: an expression
+ * matches when it uses exactly that many labels and their truth table
+ * (same layout as truth_table()) equals the target. */
+
+constexpr int kMaxSearchVars = 4;
+
+struct SearchOptions {
+    int maxSize = 24; // sizes beyond this (or size_limit()) are not tried
+};
+
+/* nullopt when no expression up to the size bound computes the target.
+ * Throws std::runtime_error for 0 or more than kMaxSearchVars variables
+ * or a table with bits beyond its 2^vars rows. */
+std::optional<bigint> find_min_index(const TruthTable &target,
+                                     const SearchOptions &opts = {});
+/* Target as a row mask: bit r is the value for row r, variable i being
+ * bit i of r */
+std::optional<bigint> find_min_index(int vars, std::uint64_t mask,
+                                     const SearchOptions &opts = {});
+
+#endif // SEARCH_H
@@ -0,0 +1,111 @@
+#ifndef TIERED_H
+#define TIERED_H
+
+#include "compute_data.h"
+#include <boost/multiprecision/cpp_int.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Integer tiers for unranking.
+ *
+ * The unrankers are templated on the index type and instantiated for
+ * u64, u128, a fixed 1024-bit stack integer and bigint. dispatch() picks
+ * the narrowest tier that holds N, so the common small-index path never
+ * touches the allocator. Narrow tiers keep their own saturated per-size
+ * layers: any entry that does not fit becomes the tier's maximum, which
+ * still compares greater than every index the tier accepts. */
+namespace tiered {
+
+using u64 = std::uint64_t;
+__extension__ typedef unsigned __int128 u128;
+using u1024 = boost::multiprecision::number<
+    boost::multiprecision::cpp_int_backend<
+        1024, 1024, boost::multiprecision::unsigned_magnitude,
+        boost::multiprecision::unchecked, void>>;
+
+/* Size-n layer for one tier (bigint shares size_layer()) */
+template <class Int> const SizeLayer<Int> &layer(int n);
+/* Number of layers built so far (sizes 0…built_sizes()-1) */
+template <class Int> int built_sizes();
+/* Cumulative split counts of the B-rooted shapes with s leaves and u
+ * unary nodes: entry (ls-1)(u+1) + u1 is the rank offset of split
+ * (ls, u1) among them; built on first use */
+template <class Int> const std::vector<Int> &split_table(int s, int u);
+
+/* Table lookups for one tier, indexed like compute_data.h */
+template <class Int> struct Tables {
+    static const Int &Pow3(int k) { return layer<Int>(k).Pow3; }
+    static const Int &Bell(int s) { return s ? layer<Int>(s - 1).Bell : one(); }
+    static const Int &C(int s, int u) {
+        return s ? layer<Int>(s - 1 + u).C[s - 1] : zero();
+    }
+    static const Int &DP_RGS(int len, int max) {
+        return len + max ? layer<Int>(len + max - 1).DP_RGS[len] : one();
+    }
+    static const Int &prefixN(int n) { return layer<Int>(n).prefixN; }
+    static const Int &ShapeSpan(int s) { return layer<Int>(s - 1).ShapeSpan; }
+    static const std::vector<Int> &BlockStart(int n) {
+        return layer<Int>(n).BlockStart;
+    }
+    static const Int &RGSReuse(int len, int max) {
+        return len + max ? layer<Int>(len + max - 1).RGSReuse[len] : one();
+    }
+
+  private:
+    static const Int &zero() {
+        static const Int z = 0;
+        return z;
+    }
+    static const Int &one() {
+        static const Int o = 1;
+        return o;
+    }
+};
+
+/* Narrows a bigint, saturating at the tier maximum */
+template <class Int> Int narrow(const bigint &v) {
+    if constexpr (std::is_same_v<Int, bigint>) {
+        return v;
+    } else {
+        static const bigint top = bigint(~Int(0));
+        if (v >= top)
+            return ~Int(0);
+        return Int(v);
+    }
+}
+
+template <class Int> bigint widen(const Int &v) { return bigint(v); }
+
+/* Calls f with N converted to the narrowest tier below its saturation
+ * point */
+template <class F> decltype(auto) dispatch(const bigint &N, F &&f) {
+    if (N >= 0) {
+        unsigned bits = N == 0 ? 0 : unsigned(msb(N)) + 1;
+        if (bits < 64)
+            return f(N.convert_to<u64>());
+        if (bits < 128)
+            return f(N.convert_to<u128>());
+        if (bits < 1024)
+            return f(u1024(N));
+    }
+    return f(N);
+}
+
+template <class Int> std::vector<int> unrank_rgs(int len, Int k);
+template <class Int> std::string unrank_shape(int s, int u, Int k);
+/* unrank_shape into sig, reusing its capacity */
+template <class Int>
+void unrank_shape_into(int s, int u, Int k, std::string &sig);
+template <class Int>
+std::vector<std::uint8_t> decode_ops(const std::string &sig, Int opIdx);
+template <class Int>
+std::string emit_expr(const std::string &sig, Int opIdx,
+                      const std::vector<int> &lbl);
+template <class Int>
+void compute_expr_components(const Int &N, std::string &sig, Int &opIdx,
+                             std::vector<int> &labels);
+
+} // namespace tiered
+
+#endif // TIERED_H
@@ -0,0 +1,33 @@
+#ifndef TRUTH_TABLE_H
+#define TRUTH_TABLE_H
+
+#include "compute.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Widest table we are willing to materialise (2^26 rows = 8 MiB) */
+constexpr int kMaxTruthTableVars = 26;
+
+/* Full truth table of an expression, one bit per input row.
+ *
+ * Variables follow label order (A, B, …) and variable i is bit i of the
+ * row number, so row r lives in bit r % 64 of words[r / 64]. Tables with
+ * fewer than 6 variables use the low 2^vars bits of a single word. */
+struct TruthTable {
+    int vars = 0;
+    std::vector<std::uint64_t> words;
+
+    bool row(std::uint64_t r) const { return words[r >> 6] >> (r & 63) & 1; }
+    bool operator==(const TruthTable &) const = default;
+};
+
+TruthTable truth_table(const std::string &sig,
+                       const std::vector<std::uint8_t> &ops,
+                       const std::vector<int> &labels);
+TruthTable truth_table(bigint N);
+/* Refills `out`, keeping its capacity (for bulk use) */
+void truth_table(const std::string &sig, const std::vector<std::uint8_t> &ops,
+                 const std::vector<int> &labels, TruthTable &out);
+
+#endif // TRUTH_TABLE_H
@@ -0,0 +1,157 @@
+#include "classify.h"
+#include "compute_data.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+constexpr std::size_t kShards = 64;
+
+/* murmur3 finaliser */
+std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    return x ^ (x >> 33);
+}
+
+struct TableHash {
+    std::size_t operator()(const TruthTable &t) const {
+        std::uint64_t h = mix(std::uint64_t(t.vars));
+        for (std::uint64_t w : t.words)
+            h = mix(h ^ w);
+        return std::size_t(h);
+    }
+};
+
+struct Entry {
+    std::uint64_t count = 0;
+    bigint first;
+    int minSize = 0;
+};
+
+using Map = std::unordered_map<TruthTable, Entry, TableHash>;
+
+void merge_entry(Entry &into, Entry &&e) {
+    if (into.count == 0 || e.first < into.first) {
+        into.first = std::move(e.first);
+        into.minSize = e.minSize;
+    }
+    into.count += e.count;
+}
+
+/* Shared aggregate, locked per shard; admits at most `cap` functions */
+class SharedMap {
+  public:
+    explicit SharedMap(std::size_t cap) : cap_(cap) {}
+
+    /* Moves every entry of `local` in and leaves it empty */
+    void merge(Map &local) {
+        while (!local.empty()) {
+            auto node = local.extract(local.begin());
+            Shard &sh = shards_[TableHash{}(node.key()) % kShards];
+            std::lock_guard lock(sh.mu);
+            if (auto it = sh.map.find(node.key()); it != sh.map.end()) {
+                merge_entry(it->second, std::move(node.mapped()));
+            } else if (size_.fetch_add(1, std::memory_order_relaxed) < cap_) {
+                sh.map.insert(std::move(node));
+            } else {
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                untracked_.fetch_add(node.mapped().count,
+                                     std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void collect(FunctionHistogram &out) {
+        for (auto &sh : shards_)
+            for (auto &[table, e] : sh.map)
+                out.functions.push_back(
+                    {table, e.count, std::move(e.first), e.minSize});
+        std::sort(out.functions.begin(), out.functions.end(),
+                  [](const FunctionStats &a, const FunctionStats &b) {
+                      return a.first < b.first;
+                  });
+        out.untracked = untracked_.load();
+    }
+
+  private:
+    struct Shard {
+        std::mutex mu;
+        Map map;
+    };
+    std::size_t cap_;
+    std::atomic<std::size_t> size_{0};
+    std::atomic<std::uint64_t> untracked_{0};
+    std::array<Shard, kShards> shards_;
+};
+
+struct alignas(64) Worker {
+    Map map;
+    TruthTable tt;
+    std::uint64_t expressions = 0, wide = 0;
+};
+
+} // namespace
+
+FunctionHistogram classify_range(const bigint &start, const bigint &end,
+                                 const ClassifyOptions &opts) {
+    if (opts.maxVars < 0 || opts.maxVars > kMaxTruthTableVars)
+        throw std::runtime_error("maxVars must be within 0…" +
+                                 std::to_string(kMaxTruthTableVars));
+    EnumerateOptions eo = opts.enumerate;
+    if (!eo.threads)
+        eo.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<Worker> workers(eo.threads);
+    SharedMap shared(opts.maxFunctions);
+    std::size_t flushAt = std::max<std::size_t>(1, opts.localEntries);
+
+    enumerate_range(
+        start, end,
+        [&](const ExprCursor &cur, unsigned w) {
+            Worker &wk = workers[w];
+            ++wk.expressions;
+            const auto &labels = cur.labels();
+            if (*std::max_element(labels.begin(), labels.end()) >=
+                opts.maxVars) {
+                ++wk.wide;
+                return;
+            }
+            truth_table(cur.signature(), cur.ops(), labels, wk.tt);
+            if (auto it = wk.map.find(wk.tt); it != wk.map.end()) {
+                Entry &e = it->second;
+                if (cur.index() < e.first) {
+                    e.first = cur.index();
+                    e.minSize = cur.size();
+                }
+                ++e.count;
+                return;
+            }
+            wk.map.emplace(wk.tt, Entry{1, cur.index(), cur.size()});
+            if (wk.map.size() >= flushAt)
+                shared.merge(wk.map);
+        },
+        eo);
+
+    FunctionHistogram out;
+    for (auto &wk : workers) {
+        shared.merge(wk.map);
+        out.expressions += wk.expressions;
+        out.wide += wk.wide;
+    }
+    shared.collect(out);
+    return out;
+}
+
+FunctionHistogram classify_size(int n, const ClassifyOptions &opts) {
+    if (n < 0)
+        throw std::runtime_error("Size must be non-negative");
+    return classify_range(n ? prefixN[n - 1] : bigint(0), prefixN[n], opts);
+}
@@ -0,0 +1,257 @@
+#include "classify.h"
+#include "compute_data.h"
+#include "cursor.h"
+#include "flat_expr.h"
+#include "record_io.h"
+#include "sampler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t kTextBuffer = 1 << 20;
+
+void usage() {
+    std::cerr
+        << "usage: circfinity-cli (--size N | --range START COUNT)"
+           " [--binary] [--limit L] [-o FILE]\n"
+           "       circfinity-cli --read FILE [--from K] [--count M]"
+           " [-o FILE]\n"
+           "       circfinity-cli --sample COUNT [--seed S] [--size N]"
+           " [--leaves S] [--limit L] [-o FILE]\n"
+           "       circfinity-cli --classify (--size N | --range START COUNT)"
+           " [--max-vars V] [--threads T] [-o FILE]\n";
+}
+
+void write_all(int fd, const std::string &s) {
+    const char *p = s.data();
+    std::size_t n = s.size();
+    while (n) {
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(std::string("Write failed: ") +
+                                     std::strerror(errno));
+        }
+        p += w;
+        n -= std::size_t(w);
+    }
+}
+
+/* One expression per line, flushed in ~1 MiB writes */
+void dump_text(int fd, const bigint &start, const bigint &end) {
+    ExprCursor cur(start);
+    FlatExpr flat;
+    std::string buf;
+    buf.reserve(kTextBuffer + 4096);
+    for (;;) {
+        flatten_expr(cur.signature(), cur.ops(), cur.labels(), flat);
+        emit_flat(flat, buf);
+        buf += '\n';
+        if (buf.size() >= kTextBuffer) {
+            write_all(fd, buf);
+            buf.clear();
+        }
+        if (cur.index() + 1 >= end)
+            break;
+        cur.next();
+    }
+    write_all(fd, buf);
+}
+
+void dump_binary(int fd, const bigint &start, const bigint &end) {
+    ExprCursor cur(start);
+    RecordWriter out(fd, start, ExprCursor(end - 1).size());
+    for (;;) {
+        out.append(cur.signature(), cur.ops(), cur.labels());
+        if (cur.index() + 1 >= end)
+            break;
+        cur.next();
+    }
+    out.finish();
+}
+
+void dump_records(int fd, const std::string &path, std::uint64_t from,
+                  std::uint64_t count) {
+    RecordReader in(path);
+    in.seek(std::min(from, in.size()));
+    ExprRecord r;
+    std::string buf;
+    for (std::uint64_t i = 0; i < count && in.next(r); ++i) {
+        buf += emit_expr(r.sig, r.ops, r.labels);
+        buf += '\n';
+        if (buf.size() >= kTextBuffer) {
+            write_all(fd, buf);
+            buf.clear();
+        }
+    }
+    write_all(fd, buf);
+}
+
+/* COUNT uniform draws, one expression per line */
+void dump_samples(int fd, const SampleSpec &spec, std::uint64_t count,
+                  std::uint64_t seed) {
+    ExprSampler smp(seed);
+    ExprRecord r;
+    FlatExpr flat;
+    std::string buf;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        smp.sample(spec, r);
+        flatten_expr(r.sig, r.ops, r.labels, flat);
+        emit_flat(flat, buf);
+        buf += '\n';
+        if (buf.size() >= kTextBuffer) {
+            write_all(fd, buf);
+            buf.clear();
+        }
+    }
+    write_all(fd, buf);
+}
+
+/* Truth table as hex, most significant row first */
+std::string table_hex(const TruthTable &t) {
+    static const char kHex[] = "0123456789abcdef";
+    std::size_t rows = std::size_t(1) << t.vars;
+    std::size_t digits =
+        std::max<std::size_t>(1, std::min<std::size_t>(rows / 4, 16));
+    std::string out;
+    for (std::size_t w = t.words.size(); w-- > 0;)
+        for (std::size_t d = digits; d-- > 0;)
+            out += kHex[t.words[w] >> (4 * d) & 15];
+    return out;
+}
+
+/* One line per function: vars, table, count, first index, smallest size;
+ * then a '#' summary line */
+void dump_classes(int fd, const bigint &start, const bigint &end,
+                  const ClassifyOptions &opts) {
+    auto hist = classify_range(start, end, opts);
+    std::string buf;
+    for (const auto &f : hist.functions) {
+        buf += std::to_string(f.table.vars) + '\t' + table_hex(f.table) +
+               '\t' + std::to_string(f.count) + '\t' + to_string(f.first) +
+               '\t' + std::to_string(f.minSize) + '\n';
+        if (buf.size() >= kTextBuffer) {
+            write_all(fd, buf);
+            buf.clear();
+        }
+    }
+    buf += "# expressions " + std::to_string(hist.expressions) +
+           " functions " + std::to_string(hist.functions.size()) + " wide " +
+           std::to_string(hist.wide) + " untracked " +
+           std::to_string(hist.untracked) + '\n';
+    write_all(fd, buf);
+}
+
+int run(int argc, char **argv) {
+    std::string out, readPath;
+    bigint start = -1, count = 0;
+    std::uint64_t from = 0, readCount = UINT64_MAX;
+    std::uint64_t samples = 0, seed = 0;
+    SampleSpec spec;
+    ClassifyOptions classify;
+    bool binary = false, sampling = false, classifying = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto arg = [&]() -> std::string {
+            if (i + 1 >= argc)
+                throw std::runtime_error("Missing value for " + a);
+            return argv[++i];
+        };
+        if (a == "--size") {
+            int n = std::stoi(arg());
+            if (n < 0)
+                throw std::runtime_error("Size must be non-negative");
+            if (n > size_limit())
+                set_size_limit(n);
+            start = n ? prefixN[n - 1] : bigint(0);
+            count = Wn[n];
+            spec.n = n;
+        } else if (a == "--sample") {
+            sampling = true;
+            samples = std::stoull(arg());
+        } else if (a == "--seed") {
+            seed = std::stoull(arg());
+        } else if (a == "--leaves") {
+            spec.s = std::stoi(arg());
+        } else if (a == "--classify") {
+            classifying = true;
+        } else if (a == "--max-vars") {
+            classify.maxVars = std::stoi(arg());
+        } else if (a == "--threads") {
+            classify.enumerate.threads = unsigned(std::stoul(arg()));
+        } else if (a == "--range") {
+            start = bigint(arg());
+            count = bigint(arg());
+        } else if (a == "--limit") {
+            set_size_limit(std::stoi(arg()));
+        } else if (a == "--binary") {
+            binary = true;
+        } else if (a == "-o") {
+            out = arg();
+        } else if (a == "--read") {
+            readPath = arg();
+        } else if (a == "--from") {
+            from = std::stoull(arg());
+        } else if (a == "--count") {
+            readCount = std::stoull(arg());
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (readPath.empty() && !sampling && start < 0) {
+        usage();
+        return 2;
+    }
+
+    int fd = 1;
+    if (!out.empty()) {
+        fd = ::open(out.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            throw std::runtime_error("Cannot open " + out + ": " +
+                                     std::strerror(errno));
+    }
+
+    if (!readPath.empty()) {
+        dump_records(fd, readPath, from, readCount);
+    } else if (sampling) {
+        dump_samples(fd, spec, samples, seed);
+    } else {
+        bigint end = start + count;
+        end = std::min(end, prefixN[size_limit()]);
+        if (classifying) {
+            dump_classes(fd, start, std::max(start, end), classify);
+        } else if (start < end) {
+            if (binary)
+                dump_binary(fd, start, end);
+            else
+                dump_text(fd, start, end);
+        } else if (binary) {
+            RecordWriter(fd, start, 0).finish();
+        }
+    }
+    if (fd != 1 && ::close(fd) != 0)
+        throw std::runtime_error("Cannot close " + out);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        return run(argc, argv);
+    } catch (const std::exception &e) {
+        std::cerr << "circfinity-cli: " << e.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,128 @@
+#include "compiled_expr.h"
+#include "kernels.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+constexpr std::uint32_t kNoParent = ~0u;
+
+/* Value of internal node i from its (already current) children */
+std::uint8_t node_value(const FlatExpr &e,
+                        const std::vector<std::uint8_t> &values,
+                        std::size_t i) {
+    const FlatNode &nd = e.nodes[i];
+    switch (nd.op) {
+    case NodeOp::Not:
+        return !values[i + 1];
+    case NodeOp::And:
+        return values[i + 1] & values[i + nd.right];
+    case NodeOp::Or:
+        return values[i + 1] | values[i + nd.right];
+    case NodeOp::Xor:
+        return values[i + 1] ^ values[i + nd.right];
+    default:
+        return values[i];
+    }
+}
+
+} // namespace
+
+CompiledExpr::CompiledExpr(const bigint &N) {
+    ExprRecord r;
+    compute_expr_components(N, r.sig, r.ops, r.labels);
+    flatten_expr(r.sig, r.ops, r.labels, flat_);
+    build();
+}
+
+CompiledExpr::CompiledExpr(const ExprRecord &r) {
+    flatten_expr(r.sig, r.ops, r.labels, flat_);
+    build();
+}
+
+void CompiledExpr::build() {
+    const auto &nodes = flat_.nodes;
+    inputs_.assign(flat_.vars, 0);
+    nodeBits_.resize((nodes.size() + 31) / 32);
+    evaluate_flat(flat_, inputs_.data(), values_);
+
+    /* parent links and per-variable leaf lists (counting sort on label) */
+    parent_.assign(nodes.size(), kNoParent);
+    leafStart_.assign(flat_.vars + 1, 0);
+    for (std::uint32_t i = 0; i < nodes.size(); ++i) {
+        const FlatNode &nd = nodes[i];
+        if (nd.op == NodeOp::Var) {
+            ++leafStart_[nd.label + 1];
+            continue;
+        }
+        parent_[i + 1] = i;
+        if (nd.op != NodeOp::Not)
+            parent_[i + nd.right] = i;
+    }
+    for (int v = 0; v < flat_.vars; ++v)
+        leafStart_[v + 1] += leafStart_[v];
+    leafIds_.resize(leafStart_[flat_.vars]);
+    auto fill = leafStart_;
+    for (std::uint32_t i = 0; i < nodes.size(); ++i)
+        if (nodes[i].op == NodeOp::Var)
+            leafIds_[fill[nodes[i].label]++] = i;
+    queued_.assign(nodes.size(), 0);
+}
+
+/* Unpacks the mask into one byte per variable for evaluate_flat */
+void CompiledExpr::load(const std::uint32_t *mask) {
+    kernels::unpack_bits(mask, inputs_.data(), inputs_.size());
+}
+
+bool CompiledExpr::eval(const std::uint32_t *mask) {
+    load(mask);
+    return evaluate_flat(flat_, inputs_.data(), values_);
+}
+
+const std::vector<std::uint32_t> &
+CompiledExpr::eval_nodes(const std::uint32_t *mask) {
+    load(mask);
+    evaluate_flat(flat_, inputs_.data(), values_);
+    kernels::pack_bits(values_.data(), nodeBits_.data(), values_.size());
+    return nodeBits_;
+}
+
+/* Children sit after their parent in preorder, so popping dirty nodes
+ * highest index first (a max-heap) settles every child before its parent
+ * and each node is recomputed at most once. */
+const std::vector<std::uint32_t> &CompiledExpr::flip(int v) {
+    if (v < 0 || v >= flat_.vars)
+        throw std::runtime_error("Variable out of range: " +
+                                 std::to_string(v));
+    inputs_[v] ^= 1;
+    changed_.clear();
+    dirty_.clear();
+
+    auto mark = [&](std::uint32_t i) {
+        std::uint32_t p = parent_[i];
+        if (p != kNoParent && !queued_[p]) {
+            queued_[p] = 1;
+            dirty_.push_back(p);
+            std::push_heap(dirty_.begin(), dirty_.end());
+        }
+    };
+    for (auto k = leafStart_[v]; k < leafStart_[v + 1]; ++k) {
+        std::uint32_t i = leafIds_[k];
+        values_[i] = inputs_[v];
+        changed_.push_back(i);
+        mark(i);
+    }
+    while (!dirty_.empty()) {
+        std::pop_heap(dirty_.begin(), dirty_.end());
+        std::uint32_t i = dirty_.back();
+        dirty_.pop_back();
+        queued_[i] = 0;
+        std::uint8_t val = node_value(flat_, values_, i);
+        if (val == values_[i])
+            continue;
+        values_[i] = val;
+        changed_.push_back(i);
+        mark(i);
+    }
+    return changed_;
+}
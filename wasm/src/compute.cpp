@@ -1,24 +1,23 @@
 #include "compute_data.h"
+#include "decimal.h"
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <compute.h>
+#include <flat_expr.h>
+#include <instrument.h>
+#include <tiered.h>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
-/* Converts bigint to decimal string (stack buffer, no heap) */
-std::string to_string(bigint x) {
-    char buf[500];
-    char *p = std::end(buf);
-    do {
-        *--p = char('0' + x % 10);
-        x /= 10;
-    } while (x);
-    return {p, std::end(buf)};
-}
+/* Converts bigint to decimal string (see decimal.h) */
+std::string to_string(bigint x) { return to_decimal(x); }
 
 // Minimal JSON parser for flat { "A": true, "B": false }
 std::unordered_map<std::string, bool> parse_input_map(const std::string &json) {
+    CIRC_PHASE(ParseInputs);
     std::unordered_map<std::string, bool> result;
     size_t i = 0;
     auto skip_ws = [&]() {
@@ -79,59 +78,30 @@ std::string evaluate_expr_full_json(bigint N, const std::string &jsonInputs) {
     auto inputs = parse_input_map(jsonInputs);
 
     std::string sig;
-    bigint opIdx;
+    std::vector<std::uint8_t> ops;
     std::vector<int> labels;
-    compute_expr_components(N, sig, opIdx, labels);
-    auto [_, tree] = emit_expr_both(sig, opIdx, labels);
-
-    std::unordered_map<const ExprTree *, std::string> id_map;
-    std::unordered_map<std::string, bool> result_map;
-    int id_counter = 0;
-
-    std::function<bool(const ExprTree *)> dfs =
-        [&](const ExprTree *node) -> bool {
-        if (!node)
-            throw std::runtime_error("Null node in evaluation");
-
-        std::string node_id = "n" + std::to_string(id_counter++);
-        id_map[node] = node_id;
-
-        bool val;
-        if (node->type == "VAR") {
-            auto it = inputs.find(node->value);
-            if (it == inputs.end())
-                throw std::runtime_error("Missing input for variable: " +
-                                         node->value);
-            val = it->second;
-        } else if (node->type == "NOT") {
-            val = !dfs(node->left.get());
-        } else {
-            bool lhs = dfs(node->left.get());
-            bool rhs = dfs(node->right.get());
-
-            if (node->type == "AND")
-                val = lhs && rhs;
-            else if (node->type == "OR")
-                val = lhs || rhs;
-            else if (node->type == "XOR")
-                val = lhs ^ rhs;
-            else
-                throw std::runtime_error("Unknown node type: " + node->type);
-        }
-
-        result_map[node_id] = val;
-        return val;
-    };
-
-    dfs(tree.get());
+    compute_expr_components(N, sig, ops, labels);
+    thread_local FlatExpr flat;
+    flatten_expr(sig, ops, labels, flat);
+
+    std::vector<std::uint8_t> in(flat.vars);
+    for (int v = 0; v < flat.vars; ++v) {
+        auto it = inputs.find(Labels[v]);
+        if (it == inputs.end())
+            throw std::runtime_error("Missing input for variable: " +
+                                     Labels[v]);
+        in[v] = it->second;
+    }
+    std::vector<std::uint8_t> values;
+    evaluate_flat(flat, in.data(), values);
 
+    CIRC_PHASE(EmitJson);
     std::string json = "{";
-    bool first = true;
-    for (const auto &[ptr, name] : id_map) {
-        if (!first)
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i)
             json += ",";
-        first = false;
-        json += "\"" + name + "\":" + (result_map[name] ? "true" : "false");
+        json += "\"n" + std::to_string(i) + "\":";
+        json += values[i] ? "true" : "false";
     }
     json += "}";
     return json;
@@ -155,46 +125,21 @@ std::string serialise_tree(const ExprTree *node) {
 
 /* Unranks a restricted growth string (used for variable partitioning) */
 std::vector<int> unrank_rgs(int len, bigint k) {
-    std::vector<int> r(len);
-    int cur = 0;
-    for (int i = 0; i < len; ++i) {
-        for (int v = 0;; ++v) {
-            bigint cnt = DP_RGS[len - i - 1][std::max(cur, v)];
-            if (k < cnt) {
-                r[i] = v;
-                if (v == cur + 1)
-                    ++cur;
-                break;
-            }
-            k -= cnt;
-        }
-    }
-    return r;
+    return tiered::dispatch(
+        k, [&](const auto &v) { return tiered::unrank_rgs(len, v); });
 }
 
 /* Unranks a shape (preorder string of L/U/B) given leaf/unary count */
 std::string unrank_shape(int s, int u, bigint k) {
-    if (s == 1)
-        return u ? "U" + unrank_shape(1, u - 1, k) : "L";
-    if (u) {
-        bigint c = C[s][u - 1];
-        if (k < c)
-            return "U" + unrank_shape(s, u - 1, k);
-        k -= c;
-    }
-    for (int ls = 1; ls < s; ++ls) {
-        int rs = s - ls;
-        for (int u1 = 0; u1 <= u; ++u1) {
-            bigint block = C[ls][u1] * C[rs][u - u1];
-            if (k < block) {
-                bigint l = k / C[rs][u - u1], r = k % C[rs][u - u1];
-                return "B" + unrank_shape(ls, u1, l) +
-                       unrank_shape(rs, u - u1, r);
-            }
-            k -= block;
-        }
-    }
-    throw;
+    CIRC_PHASE(UnrankShape);
+    return tiered::dispatch(
+        k, [&](const auto &v) { return tiered::unrank_shape(s, u, v); });
+}
+
+/* Splits opIdx into one base-3 digit per binary node (preorder) */
+std::vector<std::uint8_t> decode_ops(const std::string &sig, bigint opIdx) {
+    return tiered::dispatch(
+        opIdx, [&](const auto &v) { return tiered::decode_ops(sig, v); });
 }
 
 /* Builds both expression string and tree from signature + operator/label
@@ -202,125 +147,353 @@ std::string unrank_shape(int s, int u, bigint k) {
 std::pair<std::string, std::unique_ptr<ExprTree>>
 emit_expr_both(const std::string &sig, bigint opIdx,
                const std::vector<int> &lbl) {
-    static constexpr const char *OPSTR[3] = {"AND", "OR", "XOR"};
-    size_t sigPos = 0, lblPos = 0;
+    thread_local FlatExpr flat;
+    flatten_expr(sig, decode_ops(sig, opIdx), lbl, flat);
     std::string out;
     out.reserve(sig.size() * 4);
-
-    std::function<std::unique_ptr<ExprTree>()> dfs =
-        [&]() -> std::unique_ptr<ExprTree> {
-        char t = sig[sigPos++];
-        if (t == 'L') {
-            std::string v = Labels[lbl[lblPos++]];
-            out += v;
-            return std::make_unique<ExprTree>(ExprTree{"VAR", v});
-        } else if (t == 'U') {
-            out += "NOT(";
-            auto child = dfs();
-            out += ')';
-            return std::make_unique<ExprTree>(
-                ExprTree{"NOT", "", std::move(child)});
-        } else {
-            int o = int(opIdx % 3);
-            opIdx /= 3;
-            std::string op = OPSTR[o];
-            out += op + "(";
-            auto l = dfs();
-            out += ',';
-            auto r = dfs();
-            out += ')';
-            return std::make_unique<ExprTree>(
-                ExprTree{op, "", std::move(l), std::move(r)});
-        }
-    };
-
-    auto tree = dfs();
-    return {out, std::move(tree)};
+    emit_flat(flat, out);
+    return {out, to_tree(flat)};
 }
 
 /* builds the expression string */
 std::string emit_expr(const std::string &sig, bigint opIdx,
                       const std::vector<int> &lbl) {
-    static constexpr const char *OPSTR[3] = {"AND", "OR", "XOR"};
-    size_t sigPos = 0, lblPos = 0;
+    return emit_expr(sig, decode_ops(sig, opIdx), lbl);
+}
+
+/* builds the expression string from per-node operator digits */
+std::string emit_expr(const std::string &sig,
+                      const std::vector<std::uint8_t> &ops,
+                      const std::vector<int> &lbl) {
+    thread_local FlatExpr flat;
+    flatten_expr(sig, ops, lbl, flat);
     std::string out;
     out.reserve(sig.size() * 4);
-
-    std::function<void()> dfs = [&]() {
-        char t = sig[sigPos++];
-        if (t == 'L') {
-            out += Labels[lbl[lblPos++]];
-        } else if (t == 'U') {
-            out += "NOT(";
-            dfs();
-            out += ")";
-        } else {
-            int o = int(opIdx % 3);
-            opIdx /= 3;
-            out += OPSTR[o];
-            out += "(";
-            dfs();
-            out += ",";
-            dfs();
-            out += ")";
-        }
-    };
-
-    dfs();
+    emit_flat(flat, out);
     return out;
 }
 
 /* Computes shape, opIdx, and labels for nth expression */
 void compute_expr_components(bigint N, std::string &sig, bigint &opIdx,
                              std::vector<int> &labels) {
-    int n = 0, hi = MAX_N;
-    while (n < hi) {
-        int m = (n + hi) / 2;
-        (prefixN[m] > N) ? hi = m : n = m + 1;
+    tiered::dispatch(N, [&](const auto &n) {
+        std::decay_t<decltype(n)> op;
+        tiered::compute_expr_components(n, sig, op, labels);
+        opIdx = tiered::widen(op);
+    });
+}
+
+/* Same, with the operator index already split into per-node digits */
+void compute_expr_components(bigint N, std::string &sig,
+                             std::vector<std::uint8_t> &ops,
+                             std::vector<int> &labels) {
+    tiered::dispatch(N, [&](const auto &n) {
+        std::decay_t<decltype(n)> op;
+        tiered::compute_expr_components(n, sig, op, labels);
+        ops = tiered::decode_ops(sig, op);
+    });
+}
+
+/* Returns expression string for index N */
+std::string get_expr(bigint N) {
+    std::string sig;
+    std::vector<std::uint8_t> ops;
+    std::vector<int> labels;
+    compute_expr_components(N, sig, ops, labels);
+
+    return emit_expr(sig, ops, labels);
+}
+
+/* Returns expression string + serialised tree JSON for index N */
+std::string get_expr_full(bigint N) {
+    std::string sig;
+    std::vector<std::uint8_t> ops;
+    std::vector<int> labels;
+    compute_expr_components(N, sig, ops, labels);
+    thread_local FlatExpr flat;
+    flatten_expr(sig, ops, labels, flat);
+
+    std::string out = "{\"expr\":\"";
+    out.reserve(sig.size() * 16);
+    emit_flat(flat, out);
+    out += "\",\"tree\":";
+    serialise_flat(flat, out);
+    out += '}';
+    return out;
+}
+
+/* Ranks a restricted growth string (inverse of unrank_rgs) */
+bigint rank_rgs(const std::vector<int> &r) {
+    int len = int(r.size());
+    if (len > size_limit() + 1)
+        throw std::runtime_error("Too many leaves to rank");
+    bigint k = 0;
+    int cur = 0;
+    for (int i = 0; i < len; ++i) {
+        if (r[i] < 0 || r[i] > (i ? cur + 1 : 0))
+            throw std::runtime_error("Labels are not a restricted growth "
+                                     "string");
+        /* each smaller label v ≤ cur leaves DP_RGS[rest][cur] strings */
+        k += DP_RGS[len - i - 1][cur] * r[i];
+        if (r[i] == cur + 1)
+            ++cur;
     }
-    bigint rem = N - (n ? prefixN[n - 1] : 0);
+    return k;
+}
 
-    int sSel = 0, uSel = -1, bSel = 0;
-    for (int u = n; u >= 0; --u) {
-        int s = n - u + 1, b = n - u;
-        if (s > MAX_S || u > MAX_U)
+namespace {
+
+struct ShapeRank {
+    bigint k;
+    int s, u;
+};
+
+/* Rank of a unary node over a ranked child */
+ShapeRank rank_unary(const ShapeRank &c) {
+    if (c.s + c.u > size_limit())
+        throw std::runtime_error("Shape exceeds the size limit");
+    /* a single leaf has exactly one shape per unary count */
+    if (c.s > 1 && c.k >= C[c.s][c.u + 1])
+        throw std::runtime_error("Shape is outside the enumeration");
+    return {c.s == 1 ? bigint(0) : c.k, c.s, c.u + 1};
+}
+
+/* Rank of a binary node over ranked children. The B-rooted shapes follow
+ * the C[s][u-1] unary-rooted ones, and split (l.s, l.u) starts at its
+ * entry of the cumulative split table, so there is nothing to re-sum */
+ShapeRank rank_binary(const ShapeRank &l, const ShapeRank &r) {
+    int s = l.s + r.s, u = l.u + r.u;
+    if (s - 1 + u > size_limit())
+        throw std::runtime_error("Shape exceeds the size limit");
+
+    const auto &cum = tiered::split_table<bigint>(s, u);
+    bigint k = cum[std::size_t((l.s - 1) * (u + 1) + l.u)];
+    if (u)
+        k += C[s][u - 1];
+    k += l.k * C[r.s][r.u] + r.k;
+    if (k >= C[s][u])
+        throw std::runtime_error("Shape is outside the enumeration");
+    return {k, s, u};
+}
+
+/* Ranks the subtree of sig starting at pos (inverse of unrank_shape).
+ * Iterative, with the open internal nodes on an explicit stack; a path
+ * longer than size_limit() is rejected before it is finished. */
+ShapeRank rank_shape_at(const std::string &sig, size_t &pos) {
+    struct Open {
+        char t;
+        ShapeRank left; // B only, once its left subtree is done
+        bool hasLeft;
+    };
+    std::vector<Open> open;
+    for (;;) {
+        if (pos >= sig.size())
+            throw std::runtime_error("Truncated shape signature");
+        char t = sig[pos++];
+        if (t == 'U' || t == 'B') {
+            if (int(open.size()) >= size_limit())
+                throw std::runtime_error("Shape exceeds the size limit");
+            open.push_back({t, {}, false});
             continue;
-        bigint blk = C[s][u] * Pow3[b] * Bell[s];
-        if (rem < blk) {
-            sSel = s;
-            uSel = u;
-            bSel = b;
-            break;
         }
-        rem -= blk;
+        if (t != 'L')
+            throw std::runtime_error(std::string("Unknown shape symbol: ") +
+                                     t);
+
+        /* fold the finished subtree into its ancestors */
+        ShapeRank r{0, 1, 0};
+        for (;;) {
+            if (open.empty())
+                return r;
+            Open &o = open.back();
+            if (o.t == 'B' && !o.hasLeft) {
+                o.left = std::move(r);
+                o.hasLeft = true;
+                break;
+            }
+            r = o.t == 'U' ? rank_unary(r) : rank_binary(o.left, r);
+            open.pop_back();
+        }
     }
+}
 
-    bigint shapeIdx = rem / (Pow3[bSel] * Bell[sSel]);
-    bigint tmp = rem % (Pow3[bSel] * Bell[sSel]);
-    opIdx = tmp / Bell[sSel];
-    bigint rgsIdx = tmp % Bell[sSel];
-
-    sig = unrank_shape(sSel, uSel, shapeIdx);
-    labels = unrank_rgs(sSel, rgsIdx);
+/* Decodes a bijective base-26 label ("A" → 0, "AA" → 26) */
+int label_id(std::string_view name) {
+    if (name.empty() ||
+        !std::all_of(name.begin(), name.end(),
+                     [](char c) { return c >= 'A' && c <= 'Z'; }))
+        throw std::runtime_error("Bad label: " + std::string(name));
+    long long v = 0;
+    for (char c : name) {
+        v = v * 26 + (c - 'A' + 1);
+        if (v > (long long)size_limit() + 1)
+            throw std::runtime_error("Label out of range: " +
+                                     std::string(name));
+    }
+    return int(v - 1);
 }
 
-/* Returns expression string for index N */
-std::string get_expr(bigint N) {
+/* Parser for AND(…)/OR(…)/XOR(…)/NOT(…) text. Iterative: the
+ * punctuation still owed by the open calls is kept on a stack, and input
+ * with more operators than size_limit() is rejected as soon as the count
+ * passes it. */
+struct ExprParser {
+    explicit ExprParser(std::string_view t) : txt(t) {}
+
+    std::string_view txt;
+    size_t i = 0;
     std::string sig;
-    bigint opIdx;
+    bigint opIdx = 0;
+    int binCount = 0;
     std::vector<int> labels;
-    compute_expr_components(N, sig, opIdx, labels);
 
-    return emit_expr(sig, opIdx, labels);
+    void skip_ws() {
+        while (i < txt.size() && std::isspace((unsigned char)txt[i]))
+            ++i;
+    }
+
+    void expect(char c) {
+        skip_ws();
+        if (i >= txt.size() || txt[i] != c)
+            throw std::runtime_error(std::string("Expected '") + c +
+                                     "' at offset " + std::to_string(i));
+        ++i;
+    }
+
+    void parse() {
+        std::vector<char> owed; // top is what the next finished subtree needs
+        int internal = 0;
+        for (;;) {
+            skip_ws();
+            size_t start = i;
+            while (i < txt.size() && txt[i] >= 'A' && txt[i] <= 'Z')
+                ++i;
+            std::string_view word = txt.substr(start, i - start);
+            if (word.empty())
+                throw std::runtime_error(
+                    "Expected operator or label at offset " +
+                    std::to_string(start));
+
+            skip_ws();
+            bool call = i < txt.size() && txt[i] == '(';
+            if (call) {
+                int op = word == "AND"   ? 0
+                         : word == "OR"  ? 1
+                         : word == "XOR" ? 2
+                         : word == "NOT" ? 3
+                                         : -1;
+                if (op < 0)
+                    throw std::runtime_error("Unknown operator: " +
+                                             std::string(word));
+                if (++internal > size_limit())
+                    throw std::runtime_error("Shape exceeds the size limit");
+                ++i;
+                owed.push_back(')');
+                if (op == 3) {
+                    sig += 'U';
+                } else {
+                    sig += 'B';
+                    opIdx += Pow3[binCount++] * op;
+                    owed.push_back(',');
+                }
+                continue;
+            }
+
+            sig += 'L';
+            labels.push_back(label_id(word));
+            /* close finished calls until a second operand is due */
+            bool operandDue = false;
+            while (!owed.empty() && !operandDue) {
+                char c = owed.back();
+                owed.pop_back();
+                expect(c);
+                operandDue = c == ',';
+            }
+            if (!operandDue)
+                return;
+        }
+    }
+};
+
+} // namespace
+
+/* Ranks a shape signature (inverse of unrank_shape) */
+bigint rank_shape(const std::string &sig) {
+    size_t pos = 0;
+    auto r = rank_shape_at(sig, pos);
+    if (pos != sig.size())
+        throw std::runtime_error("Trailing symbols in shape signature");
+    return r.k;
 }
 
-/* Returns expression string + serialised tree JSON for index N */
-std::string get_expr_full(bigint N) {
+/* Ranks shape, opIdx and labels back to N (inverse of
+ * compute_expr_components) */
+bigint rank_expr_components(const std::string &sig, const bigint &opIdx,
+                            const std::vector<int> &labels) {
+    size_t pos = 0;
+    auto shape = rank_shape_at(sig, pos);
+    if (pos != sig.size())
+        throw std::runtime_error("Trailing symbols in shape signature");
+    int s = shape.s, u = shape.u, b = s - 1, n = b + u;
+    if (int(labels.size()) != s)
+        throw std::runtime_error("Label count does not match leaf count");
+    if (opIdx < 0 || opIdx >= Pow3[b])
+        throw std::runtime_error("Operator index out of range");
+
+    bigint N = n ? prefixN[n - 1] : bigint(0);
+    N += BlockStart[n][s];
+    return N + (shape.k * Pow3[b] + opIdx) * Bell[s] + rank_rgs(labels);
+}
+
+/* Returns the index N of an AND/OR/XOR/NOT expression string */
+bigint rank_expr(const std::string &expr) {
+    ExprParser p{expr};
+    p.parse();
+    p.skip_ws();
+    if (p.i != expr.size())
+        throw std::runtime_error("Trailing characters at offset " +
+                                 std::to_string(p.i));
+    return rank_expr_components(p.sig, p.opIdx, p.labels);
+}
+
+/* Returns the index N of an expression tree */
+bigint rank_tree(const ExprTree *tree) {
     std::string sig;
-    bigint opIdx;
+    bigint opIdx = 0;
+    int binCount = 0;
     std::vector<int> labels;
-    compute_expr_components(N, sig, opIdx, labels);
-    auto [exprStr, tree] = emit_expr_both(sig, opIdx, labels);
-    return "{\"expr\":\"" + exprStr +
-           "\",\"tree\":" + serialise_tree(tree.get()) + "}";
+
+    /* preorder with an explicit stack: right child pushed under the left */
+    std::vector<const ExprTree *> todo{tree};
+    int internal = 0;
+    while (!todo.empty()) {
+        const ExprTree *node = todo.back();
+        todo.pop_back();
+        if (!node)
+            throw std::runtime_error("Null node in ranking");
+        if (node->type == "VAR") {
+            sig += 'L';
+            labels.push_back(label_id(node->value));
+            continue;
+        }
+        if (++internal > size_limit())
+            throw std::runtime_error("Shape exceeds the size limit");
+        if (node->type == "NOT") {
+            sig += 'U';
+            todo.push_back(node->left.get());
+            continue;
+        }
+        int op = node->type == "AND"   ? 0
+                 : node->type == "OR"  ? 1
+                 : node->type == "XOR" ? 2
+                                       : -1;
+        if (op < 0)
+            throw std::runtime_error("Unknown node type: " + node->type);
+        sig += 'B';
+        opIdx += Pow3[binCount++] * op;
+        todo.push_back(node->right.get());
+        todo.push_back(node->left.get());
+    }
+
+    return rank_expr_components(sig, opIdx, labels);
 }
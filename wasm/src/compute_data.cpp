@@ -0,0 +1,137 @@
+#include "compute_data.h"
+#include <iterator>
+
+namespace {
+
+struct LimbRef {
+    std::uint32_t off, len;
+};
+
+#include "compute_tables.inc"
+
+/* Diagonal n of C starts at n(n+1)/2 (n+1 entries); diagonal n of DP_RGS
+ * at n(n+3)/2 (n+2 entries) */
+constexpr int c_start(int n) { return n * (n + 1) / 2; }
+constexpr int dp_start(int n) { return n * (n + 3) / 2; }
+
+static_assert(std::size(kGenC) == std::size_t(c_start(kGenSize + 1)));
+static_assert(std::size(kGenDP_RGS) == std::size_t(dp_start(kGenSize + 1)));
+
+std::atomic<int> g_sizeLimit{kDefaultSizeLimit};
+
+LimbSpan span(LimbRef r) { return {kLimbs + r.off, r.len}; }
+
+bigint to_bigint(LimbRef r) {
+    bigint v;
+    if (r.len)
+        import_bits(v, kLimbs + r.off, kLimbs + r.off + r.len, 64, false);
+    return v;
+}
+
+/* Fills the derived products of layer n from its own entries and the
+ * shape spans of the smaller layers */
+void derive_layer(int n, SizeLayer<bigint> &L) {
+    L.ShapeSpan = L.Pow3 * L.Bell;
+    L.BlockStart.resize(n + 2);
+    for (int j = 0; j <= n; ++j) {
+        const bigint &span = j == n ? L.ShapeSpan : size_layer(j).ShapeSpan;
+        L.BlockStart[j + 1] = L.BlockStart[j] + L.C[j] * span;
+    }
+    L.RGSReuse.resize(n + 2);
+    for (int l = 0; l <= n + 1; ++l)
+        L.RGSReuse[l] = L.DP_RGS[l] * (n + 2 - l);
+}
+
+/* Copies the generated layer, or computes it from the smaller ones */
+void build_layer(int n, SizeLayer<bigint> &L) {
+    int e = n + 1;
+    L.C.resize(e);
+    L.DP_RGS.resize(e + 1);
+
+    if (n <= kGenSize) {
+        L.Pow3 = to_bigint(kGenPow3[n]);
+        L.Bell = to_bigint(kGenBell[n]);
+        L.Wn = to_bigint(kGenWn[n]);
+        L.prefixN = to_bigint(kGenprefixN[n]);
+        for (int i = 0; i < e; ++i)
+            L.C[i] = to_bigint(kGenC[c_start(n) + i]);
+        for (int l = 0; l <= e; ++l)
+            L.DP_RGS[l] = to_bigint(kGenDP_RGS[dp_start(n) + l]);
+        derive_layer(n, L);
+        return;
+    }
+
+    const auto &prev = size_layer(n - 1);
+    L.Pow3 = prev.Pow3 * 3;
+
+    /* DP[l][m] = (m+1)·DP[l-1][m] + DP[l-1][m+1] */
+    L.DP_RGS[0] = 1;
+    for (int l = 1; l <= e; ++l)
+        L.DP_RGS[l] = prev.DP_RGS[l - 1] * (e - l + 1) + L.DP_RGS[l - 1];
+    L.Bell = prev.DP_RGS[n]; // Bell[n+1] = DP[n][0]
+
+    /* C[s][u] = Cat(s-1)·binom(s-1+u, u): one leaf has one shape per unary
+     * count and larger shapes are B-rooted splits, so row s is a
+     * Catalan-weighted (1-x)^-s series. Each entry is one small factor away
+     * from its neighbour on the previous diagonal. */
+    for (int s = 1; s <= e; ++s) {
+        int u = e - s;
+        bigint &c = L.C[s - 1];
+        if (u) {
+            c = prev.C[s - 1] * (s - 1 + u); // from C[s][u-1]
+            c /= u;
+        } else {
+            c = prev.C[s - 2] * (2 * (2 * s - 3)); // from C[s-1][0]
+            c /= s;
+        }
+    }
+
+    /* Wn[n] = Σ_u C[n-u+1][u]·3^(n-u)·Bell[n-u+1], the last block start */
+    derive_layer(n, L);
+    L.Wn = L.BlockStart.back();
+    L.prefixN = prev.prefixN + L.Wn;
+}
+
+void build_label(int i, std::string &out) {
+    if (i <= kGenSize) {
+        out = kGenLabels[i];
+        return;
+    }
+    for (unsigned long long id = unsigned(i);; --id) {
+        out.insert(out.begin(), char('A' + id % 26));
+        id /= 26;
+        if (id == 0)
+            break;
+    }
+}
+
+constinit Layers<SizeLayer<bigint>> g_layers{build_layer};
+constinit Layers<std::string> g_labels{build_label};
+
+} // namespace
+
+int size_limit() { return g_sizeLimit.load(std::memory_order_relaxed); }
+
+void set_size_limit(int n) {
+    if (n < 0 || n > kMaxSizeLimit)
+        throw std::runtime_error("Size limit out of range: " +
+                                 std::to_string(n) + " (0…" +
+                                 std::to_string(kMaxSizeLimit) + ")");
+    g_sizeLimit.store(n, std::memory_order_relaxed);
+}
+
+const SizeLayer<bigint> &size_layer(int n) { return g_layers.at(n); }
+
+int built_sizes() { return g_layers.built(); }
+
+const std::string &table_view::label(int i) { return g_labels.at(i); }
+
+namespace table_limbs {
+int size() { return kGenSize; }
+LimbSpan Pow3(int n) { return span(kGenPow3[n]); }
+LimbSpan Bell(int n) { return span(kGenBell[n]); }
+LimbSpan C(int n, int i) { return span(kGenC[c_start(n) + i]); }
+LimbSpan DP_RGS(int n, int l) { return span(kGenDP_RGS[dp_start(n) + l]); }
+LimbSpan Wn(int n) { return span(kGenWn[n]); }
+LimbSpan prefixN(int n) { return span(kGenprefixN[n]); }
+} // namespace table_limbs
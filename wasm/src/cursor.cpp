@@ -0,0 +1,285 @@
+#include "cursor.h"
+#include "compute_data.h"
+#include "flat_expr.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+/* Steps below this are cheaper to walk than to re-decode */
+constexpr int kWalkLimit = 16;
+
+/* Length of a shape with s leaves and u unary nodes */
+constexpr int shape_len(int s, int u) { return 2 * s - 1 + u; }
+
+/* Writes the rank-0 shape for (s, u): U^u then B L B L … L */
+void first_shape(char *p, int s, int u) {
+    p = std::fill_n(p, u, 'U');
+    for (int i = 1; i < s; ++i) {
+        *p++ = 'B';
+        *p++ = 'L';
+    }
+    *p = 'L';
+}
+
+/* Counts leaves and unary nodes of the subtree starting at p */
+int subtree_counts(const char *p, int &s, int &u) {
+    int need = 1, len = 0;
+    s = u = 0;
+    while (need) {
+        char t = p[len++];
+        if (t == 'L') {
+            ++s;
+            --need;
+        } else if (t == 'U') {
+            ++u;
+        } else {
+            ++need;
+        }
+    }
+    return len;
+}
+
+} // namespace
+
+ExprCursor::ExprCursor(const bigint &N) { seek(N); }
+
+void ExprCursor::seek(const bigint &N) {
+    if (N < 0)
+        throw std::runtime_error("Index out of range");
+
+    bigint opIdx;
+    compute_expr_components(N, sig_, opIdx, rgs_);
+    s_ = int(rgs_.size());
+    u_ = int(std::count(sig_.begin(), sig_.end(), 'U'));
+    n_ = s_ - 1 + u_;
+    N_ = N;
+    shapeSpan_ = ShapeSpan[s_];
+
+    ops_ = decode_ops(sig_, opIdx);
+    rgsMax_.resize(s_);
+    for (int i = 0, m = 0; i < s_; ++i)
+        rgsMax_[i] = m = std::max(m, rgs_[i]);
+    shapeBase_ = N - opIdx * Bell[s_] - rank_rgs(rgs_);
+}
+
+bool ExprCursor::next() {
+    /* step first: comparing N_ + 1 would build a temporary every call */
+    ++N_;
+    if (n_ >= size_limit() && N_ >= prefixN[n_]) {
+        --N_;
+        return false;
+    }
+    if (next_rgs() || next_ops())
+        return true;
+    shapeBase_ += shapeSpan_;
+    if (next_shape())
+        return true;
+
+    int n = n_, u = u_;
+    if (--u < 0)
+        u = ++n;
+    enter_block(n, u);
+    return true;
+}
+
+bool ExprCursor::prev() {
+    if (N_ == 0)
+        return false;
+    --N_;
+    if (prev_rgs() || prev_ops())
+        return true;
+    seek(N_);
+    return true;
+}
+
+bool ExprCursor::advance(const bigint &delta) {
+    if (delta < 0)
+        throw std::runtime_error("Cursor can only move forward");
+    bigint target = N_ + delta;
+    for (int n = n_; target >= prefixN[n]; ++n)
+        if (n >= size_limit())
+            return false;
+    if (delta < kWalkLimit) {
+        for (int i = int(delta); i > 0; --i)
+            next();
+        return true;
+    }
+    if (target < shapeBase_ + shapeSpan_) {
+        N_ = target;
+        decode_local(target - shapeBase_);
+        return true;
+    }
+    seek(target);
+    return true;
+}
+
+/* Lexicographic RGS successor; wraps to all zeros and returns false */
+bool ExprCursor::next_rgs() {
+    for (int i = s_ - 1; i > 0; --i) {
+        if (rgs_[i] <= rgsMax_[i - 1]) {
+            int m = std::max(rgsMax_[i - 1], ++rgs_[i]);
+            rgsMax_[i] = m;
+            for (int j = i + 1; j < s_; ++j) {
+                rgs_[j] = 0;
+                rgsMax_[j] = m;
+            }
+            return true;
+        }
+    }
+    std::fill(rgs_.begin(), rgs_.end(), 0);
+    std::fill(rgsMax_.begin(), rgsMax_.end(), 0);
+    return false;
+}
+
+/* Lexicographic RGS predecessor: the decremented position is followed by
+ * the largest completion, each label one above the running maximum.
+ * Wraps to 0, 1, …, s-1 and returns false. */
+bool ExprCursor::prev_rgs() {
+    for (int i = s_ - 1; i > 0; --i) {
+        if (rgs_[i] > 0) {
+            int m = std::max(rgsMax_[i - 1], --rgs_[i]);
+            rgsMax_[i] = m;
+            for (int j = i + 1; j < s_; ++j)
+                rgs_[j] = rgsMax_[j] = ++m;
+            return true;
+        }
+    }
+    for (int i = 0; i < s_; ++i)
+        rgs_[i] = rgsMax_[i] = i;
+    return false;
+}
+
+/* Base-3 decrement; wraps to all 2s and returns false */
+bool ExprCursor::prev_ops() {
+    for (auto &o : ops_) {
+        if (o > 0) {
+            --o;
+            return true;
+        }
+        o = 2;
+    }
+    return false;
+}
+
+/* Base-3 increment, least significant digit = first binary node */
+bool ExprCursor::next_ops() {
+    for (auto &o : ops_) {
+        if (o < 2) {
+            ++o;
+            return true;
+        }
+        o = 0;
+    }
+    return false;
+}
+
+bool ExprCursor::next_shape() { return next_shape_at(sig_.data(), s_, u_); }
+
+/* Rewrites the (s, u) subtree at p into its successor in unrank_shape
+ * order; returns false if it already was the last one */
+bool ExprCursor::next_shape_at(char *p, int s, int u) {
+    if (std::equal(p, p + shape_len(s, u), last_shape(s, u).begin()))
+        return false;
+    if (*p == 'U') {
+        if (next_shape_at(p + 1, s, u - 1))
+            return true;
+        *p = 'B';
+        first_shape(p + 1, 1, 0);
+        first_shape(p + 2, s - 1, u);
+        return true;
+    }
+
+    int ls, u1;
+    char *l = p + 1;
+    char *r = l + subtree_counts(l, ls, u1);
+    if (next_shape_at(r, s - ls, u - u1))
+        return true;
+    if (next_shape_at(l, ls, u1)) {
+        first_shape(r, s - ls, u - u1);
+        return true;
+    }
+    if (u1 < u) {
+        ++u1;
+    } else {
+        ++ls;
+        u1 = 0;
+    }
+    first_shape(l, ls, u1);
+    first_shape(l + shape_len(ls, u1), s - ls, u - u1);
+    return true;
+}
+
+/* C[s][u] cuts the split blocks short, so the end of each (s, u) run is
+ * found by comparing against its last shape rather than by exhaustion */
+const std::string &ExprCursor::last_shape(int s, int u) {
+    std::size_t i = std::size_t(s + u) * (s + u - 1) / 2 + (s - 1);
+    if (i >= lastShape_.size())
+        lastShape_.resize(i + 1);
+    auto &last = lastShape_[i];
+    if (last.empty())
+        last = unrank_shape(s, u, C[s][u] - 1);
+    return last;
+}
+
+void ExprCursor::enter_block(int n, int u) {
+    n_ = n;
+    u_ = u;
+    s_ = n - u + 1;
+    sig_.resize(shape_len(s_, u_));
+    first_shape(sig_.data(), s_, u_);
+    ops_.assign(s_ - 1, 0);
+    rgs_.assign(s_, 0);
+    rgsMax_.assign(s_, 0);
+    shapeBase_ = N_;
+    shapeSpan_ = ShapeSpan[s_];
+}
+
+/* Re-decodes operator digits and RGS for an offset inside the shape */
+void ExprCursor::decode_local(const bigint &local) {
+    ops_ = decode_ops(sig_, local / Bell[s_]);
+    rgs_ = unrank_rgs(s_, local % Bell[s_]);
+    for (int i = 0, m = 0; i < s_; ++i)
+        rgsMax_[i] = m = std::max(m, rgs_[i]);
+}
+
+/* Walks the range once, appending each entry through emit(flat, out) */
+template <class Emit>
+static std::string emit_range(const bigint &start, std::size_t count,
+                              std::string_view open, char sep,
+                              std::string_view close, Emit emit) {
+    std::string out(open);
+    if (count) {
+        ExprCursor cur(start);
+        FlatExpr flat;
+        out.reserve(count * cur.signature().size() * 4);
+        for (std::size_t i = 0; i < count; ++i) {
+            if (i) {
+                if (!cur.next())
+                    break;
+                out += sep;
+            }
+            flatten_expr(cur.signature(), cur.ops(), cur.labels(), flat);
+            emit(flat, out);
+        }
+    }
+    out += close;
+    return out;
+}
+
+std::string get_expr_range(const bigint &start, std::size_t count) {
+    return emit_range(start, count, "", '\n', "",
+                      [](FlatExpr &f, std::string &o) { emit_flat(f, o); });
+}
+
+std::string get_expr_range_full(const bigint &start, std::size_t count) {
+    return emit_range(start, count, "[", ',', "]",
+                      [](FlatExpr &f, std::string &o) {
+                          o += "{\"expr\":\"";
+                          emit_flat(f, o);
+                          o += "\",\"tree\":";
+                          serialise_flat(f, o);
+                          o += '}';
+                      });
+}
@@ -0,0 +1,125 @@
+#include "expr_cache.h"
+#include <iterator>
+
+namespace {
+
+/* Backward distances up to this are stepped with prev() rather than
+ * re-unranked */
+constexpr int kStepLimit = 16;
+
+/* Payload plus rough list / map node overhead */
+std::size_t entry_bytes(const ExprRecord &r) {
+    return sizeof(ExprRecord) + 2 * sizeof(bigint) + 6 * sizeof(void *) +
+           r.sig.size() + r.ops.size() + r.labels.size() * sizeof(int);
+}
+
+ExprRecord record_of(const ExprCursor &c) {
+    return {c.signature(), c.ops(), c.labels()};
+}
+
+} // namespace
+
+ExprCache::ExprCache(const ExprCacheOptions &opts) : opts_(opts) {}
+
+const ExprRecord &ExprCache::get(const bigint &N) {
+    if (auto it = index_.find(N); it != index_.end()) {
+        ++stats_.hits;
+        lru_.splice(lru_.begin(), lru_, it->second);
+    } else {
+        place(N);
+        ++stats_.misses;
+        lru_.push_front({N, record_of(cursor_), 0});
+        insert(lru_.begin());
+    }
+    prefetch(N);
+    evict();
+    return lru_.front().rec;
+}
+
+void ExprCache::configure(const ExprCacheOptions &opts) {
+    opts_ = opts;
+    evict();
+}
+
+void ExprCache::clear() {
+    lru_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+/* Moves the cursor onto N, walking when that is cheaper than a seek */
+void ExprCache::place(const bigint &N) {
+    bigint at = cursor_.index();
+    if (at == N)
+        return;
+    if (at < N && cursor_.advance(N - at))
+        return;
+    if (at > N && at - N <= kStepLimit) {
+        while (cursor_.index() != N)
+            cursor_.prev();
+        return;
+    }
+    cursor_.seek(N);
+}
+
+void ExprCache::insert(List::iterator where) {
+    where->bytes = entry_bytes(where->rec);
+    bytes_ += where->bytes;
+    index_.emplace(where->N, where);
+}
+
+/* Collects N+1 … N+k and N-1 … N-k, decoding the missing ones with the
+ * cursor, and files them right behind N nearest first (alternating
+ * sides), so under pressure the farthest neighbours go before the near
+ * ones */
+void ExprCache::prefetch(const bigint &N) {
+    const unsigned k = opts_.prefetch;
+    auto side = [&](bool forward) {
+        auto at = [&](unsigned i) -> bigint {
+            return forward ? bigint(N + i) : bigint(N - i);
+        };
+        List out;
+        bool missing = false;
+        for (unsigned i = 1; i <= k && !missing; ++i) {
+            if (!forward && N < i)
+                break;
+            missing = !contains(at(i));
+        }
+        if (missing)
+            place(N);
+        for (unsigned i = 1; i <= k; ++i) {
+            if (!forward && N < i)
+                break;
+            if (missing && !(forward ? cursor_.next() : cursor_.prev()))
+                break;
+            bigint M = at(i);
+            if (auto it = index_.find(M); it != index_.end()) {
+                out.splice(out.end(), lru_, it->second);
+            } else if (missing) {
+                out.push_back({M, record_of(cursor_), 0});
+                insert(std::prev(out.end()));
+                ++stats_.prefetched;
+            }
+        }
+        return out;
+    };
+    List ahead = side(true), behind = side(false), staged;
+    while (!ahead.empty() || !behind.empty()) {
+        if (!ahead.empty())
+            staged.splice(staged.end(), ahead, ahead.begin());
+        if (!behind.empty())
+            staged.splice(staged.end(), behind, behind.begin());
+    }
+    lru_.splice(std::next(lru_.begin()), staged);
+}
+
+void ExprCache::evict() {
+    while (lru_.size() > 1 &&
+           (lru_.size() > opts_.capacity || bytes_ > opts_.maxBytes)) {
+        const Entry &e = lru_.back();
+        bytes_ -= e.bytes;
+        index_.erase(e.N);
+        lru_.pop_back();
+        ++stats_.evictions;
+    }
+}
@@ -0,0 +1,173 @@
+#include "flat_expr.h"
+#include "compute_data.h"
+#include "instrument.h"
+#include <algorithm>
+
+namespace {
+
+constexpr const char *OPSTR[3] = {"AND", "OR", "XOR"};
+
+bool is_binary(NodeOp op) { return op >= NodeOp::And; }
+
+} // namespace
+
+/* Lays out shape + operator digits + labels as a preorder node array */
+void flatten_expr(const std::string &sig,
+                  const std::vector<std::uint8_t> &ops,
+                  const std::vector<int> &labels, FlatExpr &out) {
+    auto &nodes = out.nodes;
+    nodes.resize(sig.size());
+    out.work.clear();
+    out.vars = 0;
+
+    size_t lblPos = 0, opPos = 0;
+    for (std::uint32_t i = 0; i < sig.size(); ++i) {
+        char t = sig[i];
+        if (t == 'B') {
+            nodes[i] = {NodeOp(int(NodeOp::And) + ops[opPos++]), 0, 0};
+            out.work.push_back(i);
+            continue;
+        }
+        if (t == 'U') {
+            nodes[i] = {NodeOp::Not, 0, 0};
+            continue;
+        }
+        int l = labels[lblPos++];
+        nodes[i] = {NodeOp::Var, std::uint16_t(l), 0};
+        out.vars = std::max(out.vars, l + 1);
+
+        /* a leaf closes subtrees: the innermost binary node still in its
+         * left branch gets its right child next */
+        while (!out.work.empty()) {
+            auto b = out.work.back();
+            if (nodes[b].right == 0) {
+                nodes[b].right = i + 1 - b;
+                break;
+            }
+            out.work.pop_back();
+        }
+    }
+}
+
+void pack_flat(const FlatExpr &e, PackedTree &out) {
+    out.ops.resize(e.nodes.size());
+    out.labels.resize(e.nodes.size());
+    for (size_t i = 0; i < e.nodes.size(); ++i) {
+        out.ops[i] = std::uint8_t(e.nodes[i].op);
+        out.labels[i] = e.nodes[i].label;
+    }
+}
+
+/* Shared open/close walk: `work` holds 2*i + (right branch started) */
+template <class Open, class Leaf, class Sep, class Close>
+static void walk_flat(FlatExpr &e, Open open, Leaf leaf, Sep sep,
+                      Close close) {
+    e.work.clear();
+    for (std::uint32_t i = 0; i < e.nodes.size(); ++i) {
+        const FlatNode &nd = e.nodes[i];
+        if (nd.op != NodeOp::Var) {
+            open(nd);
+            e.work.push_back(2 * i);
+            continue;
+        }
+        leaf(nd);
+        while (!e.work.empty()) {
+            auto &top = e.work.back();
+            const FlatNode &p = e.nodes[top >> 1];
+            if (is_binary(p.op) && !(top & 1)) {
+                sep();
+                top |= 1;
+                break;
+            }
+            close();
+            e.work.pop_back();
+        }
+    }
+}
+
+/* Appends the expression string */
+void emit_flat(FlatExpr &e, std::string &out) {
+    CIRC_PHASE(EmitText);
+    walk_flat(
+        e,
+        [&](const FlatNode &nd) {
+            out += nd.op == NodeOp::Not ? "NOT"
+                                        : OPSTR[int(nd.op) - int(NodeOp::And)];
+            out += '(';
+        },
+        [&](const FlatNode &nd) { out += Labels[nd.label]; },
+        [&] { out += ','; }, [&] { out += ')'; });
+}
+
+/* Appends the minimal JSON tree (same format as serialise_tree) */
+void serialise_flat(FlatExpr &e, std::string &out) {
+    CIRC_PHASE(EmitJson);
+    walk_flat(
+        e,
+        [&](const FlatNode &nd) {
+            if (nd.op == NodeOp::Not) {
+                out += "{\"type\":\"NOT\",\"child\":";
+            } else {
+                out += "{\"type\":\"";
+                out += OPSTR[int(nd.op) - int(NodeOp::And)];
+                out += "\",\"left\":";
+            }
+        },
+        [&](const FlatNode &nd) {
+            out += '"';
+            out += Labels[nd.label];
+            out += '"';
+        },
+        [&] { out += ",\"right\":"; }, [&] { out += '}'; });
+}
+
+/* Bottom-up pass: children always sit after their parent */
+bool evaluate_flat(const FlatExpr &e, const std::uint8_t *inputs,
+                   std::vector<std::uint8_t> &values) {
+    CIRC_PHASE(Evaluate);
+    const auto &nodes = e.nodes;
+    values.resize(nodes.size());
+    for (size_t i = nodes.size(); i-- > 0;) {
+        const FlatNode &nd = nodes[i];
+        switch (nd.op) {
+        case NodeOp::Var:
+            values[i] = inputs[nd.label];
+            break;
+        case NodeOp::Not:
+            values[i] = !values[i + 1];
+            break;
+        case NodeOp::And:
+            values[i] = values[i + 1] & values[i + nd.right];
+            break;
+        case NodeOp::Or:
+            values[i] = values[i + 1] | values[i + nd.right];
+            break;
+        case NodeOp::Xor:
+            values[i] = values[i + 1] ^ values[i + nd.right];
+            break;
+        }
+    }
+    return values[0];
+}
+
+std::unique_ptr<ExprTree> to_tree(const FlatExpr &e) {
+    CIRC_PHASE(BuildTree);
+    CIRC_COUNT(TreeNodes, e.nodes.size());
+    const auto &nodes = e.nodes;
+    std::vector<std::unique_ptr<ExprTree>> built(nodes.size());
+    for (size_t i = nodes.size(); i-- > 0;) {
+        const FlatNode &nd = nodes[i];
+        if (nd.op == NodeOp::Var)
+            built[i] = std::make_unique<ExprTree>(
+                ExprTree{"VAR", Labels[nd.label], nullptr, nullptr});
+        else if (nd.op == NodeOp::Not)
+            built[i] = std::make_unique<ExprTree>(
+                ExprTree{"NOT", "", std::move(built[i + 1]), nullptr});
+        else
+            built[i] = std::make_unique<ExprTree>(
+                ExprTree{OPSTR[int(nd.op) - int(NodeOp::And)], "",
+                         std::move(built[i + 1]),
+                         std::move(built[i + nd.right])});
+    }
+    return nodes.empty() ? nullptr : std::move(built[0]);
+}
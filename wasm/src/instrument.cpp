@@ -0,0 +1,186 @@
+#include "instrument.h"
+
+#if CIRCFINITY_INSTRUMENT
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+#endif
+
+namespace instrument {
+
+namespace {
+
+constexpr const char *kPhaseNames[kPhases] = {
+    "size_search", "block_scan", "unrank_shape", "unrank_rgs", "decode_ops",
+    "build_tree",  "emit_text",  "emit_json",    "parse_inputs", "evaluate",
+};
+constexpr const char *kCounterNames[kCounters] = {"bigint_ops",
+                                                  "tree_nodes"};
+
+#if CIRCFINITY_INSTRUMENT
+
+struct AtomicPhase {
+    std::atomic<std::uint64_t> calls{0}, ns{0}, allocs{0};
+};
+
+struct TraceEvent {
+    Phase phase;
+    std::uint32_t tid;
+    std::uint64_t start, dur; // ns since g_epoch
+};
+
+AtomicPhase g_phases[kPhases];
+std::atomic<std::uint64_t> g_counters[kCounters];
+std::atomic<std::uint64_t> g_allocs{0}, g_allocBytes{0};
+thread_local std::uint64_t t_allocs = 0;
+
+std::atomic<bool> g_tracing{false};
+std::mutex g_traceMu;
+std::vector<TraceEvent> g_trace;
+std::atomic<std::uint32_t> g_nextTid{0};
+thread_local std::uint32_t t_tid = g_nextTid++;
+
+const auto g_epoch = std::chrono::steady_clock::now();
+
+std::uint64_t now_ns() {
+    return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - g_epoch)
+                             .count());
+}
+
+#endif
+
+} // namespace
+
+const char *name(Phase p) { return kPhaseNames[std::size_t(p)]; }
+const char *name(Counter c) { return kCounterNames[std::size_t(c)]; }
+
+#if CIRCFINITY_INSTRUMENT
+
+Scope::Scope(Phase p) : phase_(p), t0_(now_ns()), allocs0_(t_allocs) {}
+
+Scope::~Scope() {
+    std::uint64_t dur = now_ns() - t0_;
+    auto &ph = g_phases[std::size_t(phase_)];
+    ph.calls.fetch_add(1, std::memory_order_relaxed);
+    ph.ns.fetch_add(dur, std::memory_order_relaxed);
+    ph.allocs.fetch_add(t_allocs - allocs0_, std::memory_order_relaxed);
+    if (g_tracing.load(std::memory_order_relaxed)) {
+        std::lock_guard lock(g_traceMu);
+        if (g_trace.size() < kMaxTraceEvents)
+            g_trace.push_back({phase_, t_tid, t0_, dur});
+    }
+}
+
+void add(Counter c, std::uint64_t n) {
+    g_counters[std::size_t(c)].fetch_add(n, std::memory_order_relaxed);
+}
+
+Stats snapshot() {
+    Stats s;
+    for (std::size_t i = 0; i < kPhases; ++i) {
+        s.phases[i].calls = g_phases[i].calls.load(std::memory_order_relaxed);
+        s.phases[i].ns = g_phases[i].ns.load(std::memory_order_relaxed);
+        s.phases[i].allocs = g_phases[i].allocs.load(std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0; i < kCounters; ++i)
+        s.counters[i] = g_counters[i].load(std::memory_order_relaxed);
+    s.allocs = g_allocs.load(std::memory_order_relaxed);
+    s.allocBytes = g_allocBytes.load(std::memory_order_relaxed);
+    return s;
+}
+
+void reset() {
+    for (auto &ph : g_phases) {
+        ph.calls = 0;
+        ph.ns = 0;
+        ph.allocs = 0;
+    }
+    for (auto &c : g_counters)
+        c = 0;
+    g_allocs = 0;
+    g_allocBytes = 0;
+    std::lock_guard lock(g_traceMu);
+    g_trace.clear();
+}
+
+void set_tracing(bool on) { g_tracing = on; }
+
+std::string trace_json() {
+    std::string out = "{\"traceEvents\":[";
+    std::lock_guard lock(g_traceMu);
+    for (std::size_t i = 0; i < g_trace.size(); ++i) {
+        const auto &e = g_trace[i];
+        if (i)
+            out += ',';
+        out += "{\"name\":\"";
+        out += name(e.phase);
+        out += "\",\"cat\":\"compute\",\"ph\":\"X\",\"ts\":";
+        out += std::to_string(double(e.start) / 1000.0);
+        out += ",\"dur\":";
+        out += std::to_string(double(e.dur) / 1000.0);
+        out += ",\"pid\":1,\"tid\":";
+        out += std::to_string(e.tid);
+        out += '}';
+    }
+    out += "],\"displayTimeUnit\":\"ns\"}";
+    return out;
+}
+
+#else
+
+Stats snapshot() { return {}; }
+void reset() {}
+void set_tracing(bool) {}
+std::string trace_json() { return "{\"traceEvents\":[]}"; }
+
+#endif
+
+std::string stats_json() {
+    Stats s = snapshot();
+    std::string out = "{\"enabled\":";
+    out += kEnabled ? "true" : "false";
+    out += ",\"phases\":{";
+    for (std::size_t i = 0; i < kPhases; ++i) {
+        const auto &ph = s.phases[i];
+        if (i)
+            out += ',';
+        out += '"';
+        out += kPhaseNames[i];
+        out += "\":{\"calls\":" + std::to_string(ph.calls) +
+               ",\"ns\":" + std::to_string(ph.ns) +
+               ",\"allocs\":" + std::to_string(ph.allocs) + '}';
+    }
+    out += "},\"counters\":{";
+    for (std::size_t i = 0; i < kCounters; ++i) {
+        if (i)
+            out += ',';
+        out += '"';
+        out += kCounterNames[i];
+        out += "\":" + std::to_string(s.counters[i]);
+    }
+    out += "},\"allocs\":" + std::to_string(s.allocs) +
+           ",\"alloc_bytes\":" + std::to_string(s.allocBytes) + '}';
+    return out;
+}
+
+} // namespace instrument
+
+#if CIRCFINITY_INSTRUMENT
+
+/* Counting allocator for the instrumented build */
+void *operator new(std::size_t n) {
+    ++instrument::t_allocs;
+    instrument::g_allocs.fetch_add(1, std::memory_order_relaxed);
+    instrument::g_allocBytes.fetch_add(n, std::memory_order_relaxed);
+    if (void *p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+#endif
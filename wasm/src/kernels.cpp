@@ -0,0 +1,258 @@
+#include "kernels.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define CIRC_KERNELS_SIMD128 1
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define CIRC_KERNELS_AVX2 1
+#endif
+
+namespace {
+
+/* Base-3 digits are cut into four 10-digit limbs (3^10 < 2^16), one per
+ * 32-bit lane; v / 3 is then (v * kThirdMul) >> kThirdShift, exact for
+ * every v < 3^10 and free of 32-bit overflow */
+[[maybe_unused]] constexpr std::uint32_t kLimb = 59049; // 3^10
+[[maybe_unused]] constexpr std::uint32_t kThirdMul = 43691;
+[[maybe_unused]] constexpr int kThirdShift = 17;
+
+/* Limb decoding only pays off once most of a chunk is wanted */
+[[maybe_unused]] constexpr std::size_t kVectorDigits = 16;
+
+void base3_scalar(std::uint64_t x, std::uint8_t *out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i, x /= 3)
+        out[i] = std::uint8_t(x % 3);
+}
+
+void unpack_scalar(const std::uint32_t *bits, std::uint8_t *out,
+                   std::size_t from, std::size_t n) {
+    for (std::size_t i = from; i < n; ++i)
+        out[i] = bits[i >> 5] >> (i & 31) & 1;
+}
+
+void pack_scalar(const std::uint8_t *in, std::uint32_t *bits,
+                 std::size_t from, std::size_t n) {
+    for (std::size_t i = from; i < n; ++i)
+        bits[i >> 5] |= std::uint32_t(in[i] & 1) << (i & 31);
+}
+
+} // namespace
+
+namespace kernels {
+
+#if defined(CIRC_KERNELS_SIMD128)
+
+const char *backend() { return "simd128"; }
+
+#define CIRC_WORDS_KERNEL(name, vop, sop)                                     \
+    void name(std::uint64_t *r, const std::uint64_t *a, std::size_t n) {      \
+        std::size_t i = 0;                                                    \
+        for (; i + 2 <= n; i += 2)                                            \
+            wasm_v128_store(r + i, vop(wasm_v128_load(r + i),                 \
+                                       wasm_v128_load(a + i)));               \
+        for (; i < n; ++i)                                                    \
+            r[i] = r[i] sop a[i];                                             \
+    }
+CIRC_WORDS_KERNEL(and_words, wasm_v128_and, &)
+CIRC_WORDS_KERNEL(or_words, wasm_v128_or, |)
+CIRC_WORDS_KERNEL(xor_words, wasm_v128_xor, ^)
+#undef CIRC_WORDS_KERNEL
+
+void not_words(std::uint64_t *r, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        wasm_v128_store(r + i, wasm_v128_not(wasm_v128_load(r + i)));
+    for (; i < n; ++i)
+        r[i] = ~r[i];
+}
+
+void base3_digits(std::uint64_t x, std::uint8_t *out, std::size_t n) {
+    if (n < kVectorDigits)
+        return base3_scalar(x, out, n);
+    std::uint32_t l0 = std::uint32_t(x % kLimb);
+    x /= kLimb;
+    std::uint32_t l1 = std::uint32_t(x % kLimb);
+    x /= kLimb;
+    std::uint32_t l2 = std::uint32_t(x % kLimb);
+    std::uint32_t l3 = std::uint32_t(x / kLimb);
+
+    v128_t v = wasm_u32x4_make(l0, l1, l2, l3);
+    const v128_t mul = wasm_u32x4_splat(kThirdMul);
+    const v128_t three = wasm_u32x4_splat(3);
+    std::uint8_t digits[40];
+    for (int k = 0; k < 10; ++k) {
+        v128_t q = wasm_u32x4_shr(wasm_i32x4_mul(v, mul), kThirdShift);
+        v128_t d = wasm_i32x4_sub(v, wasm_i32x4_mul(q, three));
+        digits[k] = std::uint8_t(wasm_u32x4_extract_lane(d, 0));
+        digits[10 + k] = std::uint8_t(wasm_u32x4_extract_lane(d, 1));
+        digits[20 + k] = std::uint8_t(wasm_u32x4_extract_lane(d, 2));
+        digits[30 + k] = std::uint8_t(wasm_u32x4_extract_lane(d, 3));
+        v = q;
+    }
+    std::memcpy(out, digits, n);
+}
+
+/* 16 variables per step: the two mask bytes are spread over eight lanes
+ * each and every lane keeps its own bit */
+void unpack_bits(const std::uint32_t *bits, std::uint8_t *out, std::size_t n) {
+    const v128_t spread =
+        wasm_i8x16_make(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1);
+    const v128_t select = wasm_i8x16_make(1, 2, 4, 8, 16, 32, 64, -128, 1, 2,
+                                          4, 8, 16, 32, 64, -128);
+    const v128_t one = wasm_i8x16_splat(1);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        auto half = std::uint16_t(bits[i >> 5] >> (i & 31));
+        v128_t v = wasm_i8x16_swizzle(wasm_i16x8_splat(std::int16_t(half)),
+                                      spread);
+        v = wasm_i8x16_eq(wasm_v128_and(v, select), select);
+        wasm_v128_store(out + i, wasm_v128_and(v, one));
+    }
+    unpack_scalar(bits, out, i, n);
+}
+
+void pack_bits(const std::uint8_t *in, std::uint32_t *bits, std::size_t n) {
+    std::fill_n(bits, (n + 31) / 32, 0);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        v128_t v = wasm_i8x16_shl(wasm_v128_load(in + i), 7);
+        bits[i >> 5] |= std::uint32_t(wasm_i8x16_bitmask(v)) << (i & 31);
+    }
+    pack_scalar(in, bits, i, n);
+}
+
+#elif defined(CIRC_KERNELS_AVX2)
+
+const char *backend() { return "avx2"; }
+
+#define CIRC_WORDS_KERNEL(name, vop, sop)                                     \
+    void name(std::uint64_t *r, const std::uint64_t *a, std::size_t n) {      \
+        std::size_t i = 0;                                                    \
+        for (; i + 4 <= n; i += 4) {                                          \
+            auto *pr = reinterpret_cast<__m256i *>(r + i);                    \
+            auto *pa = reinterpret_cast<const __m256i *>(a + i);              \
+            _mm256_storeu_si256(                                              \
+                pr, vop(_mm256_loadu_si256(pr), _mm256_loadu_si256(pa)));     \
+        }                                                                     \
+        for (; i < n; ++i)                                                    \
+            r[i] = r[i] sop a[i];                                             \
+    }
+CIRC_WORDS_KERNEL(and_words, _mm256_and_si256, &)
+CIRC_WORDS_KERNEL(or_words, _mm256_or_si256, |)
+CIRC_WORDS_KERNEL(xor_words, _mm256_xor_si256, ^)
+#undef CIRC_WORDS_KERNEL
+
+void not_words(std::uint64_t *r, std::size_t n) {
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto *pr = reinterpret_cast<__m256i *>(r + i);
+        _mm256_storeu_si256(pr, _mm256_xor_si256(_mm256_loadu_si256(pr), ones));
+    }
+    for (; i < n; ++i)
+        r[i] = ~r[i];
+}
+
+/* Four limbs fill a 128-bit register; a 256-bit one would need twice the
+ * serial limb divisions for the same 40 digits */
+void base3_digits(std::uint64_t x, std::uint8_t *out, std::size_t n) {
+    if (n < kVectorDigits)
+        return base3_scalar(x, out, n);
+    int l0 = int(x % kLimb);
+    x /= kLimb;
+    int l1 = int(x % kLimb);
+    x /= kLimb;
+    int l2 = int(x % kLimb);
+    int l3 = int(x / kLimb);
+
+    __m128i v = _mm_setr_epi32(l0, l1, l2, l3);
+    const __m128i mul = _mm_set1_epi32(int(kThirdMul));
+    const __m128i three = _mm_set1_epi32(3);
+    std::uint8_t digits[40];
+    for (int k = 0; k < 10; ++k) {
+        __m128i q = _mm_srli_epi32(_mm_mullo_epi32(v, mul), kThirdShift);
+        __m128i d = _mm_sub_epi32(v, _mm_mullo_epi32(q, three));
+        digits[k] = std::uint8_t(_mm_extract_epi32(d, 0));
+        digits[10 + k] = std::uint8_t(_mm_extract_epi32(d, 1));
+        digits[20 + k] = std::uint8_t(_mm_extract_epi32(d, 2));
+        digits[30 + k] = std::uint8_t(_mm_extract_epi32(d, 3));
+        v = q;
+    }
+    std::memcpy(out, digits, n);
+}
+
+/* 32 variables (one mask word) per step: each 128-bit half spreads two
+ * of its bytes over eight lanes each */
+void unpack_bits(const std::uint32_t *bits, std::uint8_t *out, std::size_t n) {
+    const __m256i spread = _mm256_setr_epi8(
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, //
+        2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i select = _mm256_set1_epi64x(
+        std::int64_t(0x8040201008040201ULL));
+    const __m256i one = _mm256_set1_epi8(1);
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_shuffle_epi8(
+            _mm256_set1_epi32(int(bits[i >> 5])), spread);
+        v = _mm256_cmpeq_epi8(_mm256_and_si256(v, select), select);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                            _mm256_and_si256(v, one));
+    }
+    unpack_scalar(bits, out, i, n);
+}
+
+void pack_bits(const std::uint8_t *in, std::uint32_t *bits, std::size_t n) {
+    std::fill_n(bits, (n + 31) / 32, 0);
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(in + i));
+        bits[i >> 5] = std::uint32_t(
+            _mm256_movemask_epi8(_mm256_slli_epi16(v, 7)));
+    }
+    pack_scalar(in, bits, i, n);
+}
+
+#else
+
+const char *backend() { return "scalar"; }
+
+void and_words(std::uint64_t *r, const std::uint64_t *a, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i)
+        r[i] &= a[i];
+}
+
+void or_words(std::uint64_t *r, const std::uint64_t *a, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i)
+        r[i] |= a[i];
+}
+
+void xor_words(std::uint64_t *r, const std::uint64_t *a, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i)
+        r[i] ^= a[i];
+}
+
+void not_words(std::uint64_t *r, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i)
+        r[i] = ~r[i];
+}
+
+void base3_digits(std::uint64_t x, std::uint8_t *out, std::size_t n) {
+    base3_scalar(x, out, n);
+}
+
+void unpack_bits(const std::uint32_t *bits, std::uint8_t *out, std::size_t n) {
+    unpack_scalar(bits, out, 0, n);
+}
+
+void pack_bits(const std::uint8_t *in, std::uint32_t *bits, std::size_t n) {
+    std::fill_n(bits, (n + 31) / 32, 0);
+    pack_scalar(in, bits, 0, n);
+}
+
+#endif
+
+} // namespace kernels
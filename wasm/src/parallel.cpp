@@ -0,0 +1,340 @@
+#include "parallel.h"
+#include "compute_data.h"
+#include "flat_expr.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace {
+
+/* Total size of the index's expression (prefixN[n-1] <= N < prefixN[n]) */
+int size_of(const bigint &N) {
+    int n = 0;
+    while (prefixN[n] <= N)
+        ++n;
+    return n;
+}
+
+/* Relative decoding cost of one index of size n */
+bigint weight(int n) { return n + 1; }
+
+/* One worker's chunk ids: the owner takes from the front (keeping its
+ * cursor on consecutive chunks), thieves from the back */
+struct ChunkDeque {
+    std::mutex mu;
+    std::deque<std::size_t> ids;
+
+    std::optional<std::size_t> take(bool own) {
+        std::lock_guard lock(mu);
+        if (ids.empty())
+            return std::nullopt;
+        std::size_t id;
+        if (own) {
+            id = ids.front();
+            ids.pop_front();
+        } else {
+            id = ids.back();
+            ids.pop_back();
+        }
+        return id;
+    }
+};
+
+/* One enumerate_chunks call as seen by the pool */
+struct Job {
+    const std::vector<RangeChunk> &chunks;
+    const ChunkSink &sink;
+    unsigned workers;
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorMu;
+
+    void fail() {
+        std::lock_guard lock(errorMu);
+        if (!error)
+            error = std::current_exception();
+        failed = true;
+    }
+};
+
+/* Places cur on c.begin, stepping when c follows the previous chunk */
+void move_to(std::optional<ExprCursor> &cur, const RangeChunk &c) {
+    if (!cur)
+        cur.emplace(c.begin);
+    else if (cur->index() + 1 == c.begin)
+        cur->next();
+    else if (cur->index() != c.begin)
+        cur->seek(c.begin);
+}
+
+thread_local bool t_poolWorker = false;
+
+/* Process-wide work-stealing pool, started on first use and grown to the
+ * largest worker count asked for; its threads live until exit. Workers
+ * own their chunk deque and ExprCursor across jobs, so a range that
+ * continues the previous one steps instead of re-seeking. Jobs run one
+ * at a time, on workers 0…workers-1, and the caller sleeps until the
+ * last of them is done. */
+class WorkerPool {
+  public:
+    static WorkerPool &instance() {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard lock(mu_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto &w : workers_)
+            w->thread.join();
+    }
+
+    void run(Job &job) {
+        std::lock_guard jobLock(jobMu_);
+        while (workers_.size() < job.workers) {
+            auto w = std::make_unique<Worker>();
+            w->thread = std::thread(&WorkerPool::loop, this, unsigned(workers_.size()));
+            workers_.push_back(std::move(w));
+        }
+        /* contiguous runs per worker, so cursors mostly step instead of
+         * seek */
+        const std::size_t n = job.chunks.size();
+        for (std::size_t i = 0; i < n; ++i)
+            workers_[i * job.workers / n]->deque.ids.push_back(i);
+
+        std::unique_lock lock(mu_);
+        job_ = &job;
+        running_ = job.workers;
+        ++generation_;
+        wake_.notify_all();
+        done_.wait(lock, [&] { return running_ == 0; });
+        job_ = nullptr;
+        for (auto &w : workers_) // left over after a failure
+            w->deque.ids.clear();
+    }
+
+  private:
+    struct Worker {
+        ChunkDeque deque;
+        std::optional<ExprCursor> cursor;
+        std::thread thread;
+    };
+
+    WorkerPool() = default;
+
+    void loop(unsigned w) {
+        t_poolWorker = true;
+        std::uint64_t seen = 0;
+        for (;;) {
+            Job *job;
+            {
+                std::unique_lock lock(mu_);
+                wake_.wait(lock, [&] {
+                    return stop_ ||
+                           (generation_ != seen && job_ && w < job_->workers);
+                });
+                if (stop_)
+                    return;
+                seen = generation_;
+                job = job_;
+            }
+            work(w, *job);
+            std::lock_guard lock(mu_);
+            if (--running_ == 0)
+                done_.notify_all();
+        }
+    }
+
+    void work(unsigned w, Job &job) {
+        Worker &self = *workers_[w];
+        try {
+            while (!job.failed.load(std::memory_order_relaxed)) {
+                auto id = self.deque.take(true);
+                for (unsigned k = 1; !id && k < job.workers; ++k)
+                    id = workers_[(w + k) % job.workers]->deque.take(false);
+                if (!id)
+                    return;
+                const RangeChunk &c = job.chunks[*id];
+                move_to(self.cursor, c);
+                job.sink(c, *self.cursor, w);
+            }
+        } catch (...) {
+            job.fail();
+        }
+    }
+
+    /* workers_ only changes in run(), between jobs */
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex jobMu_; // one job at a time
+    std::mutex mu_;
+    std::condition_variable wake_, done_;
+    Job *job_ = nullptr;
+    unsigned running_ = 0;
+    std::uint64_t generation_ = 0;
+    bool stop_ = false;
+};
+
+} // namespace
+
+std::vector<RangeChunk> split_range(const bigint &start, const bigint &end,
+                                    std::size_t parts) {
+    std::vector<RangeChunk> out;
+    if (start >= end || parts == 0)
+        return out;
+    if (end - start < parts)
+        parts = std::size_t(end - start);
+
+    /* per-size segments of the range and their weights */
+    struct Segment {
+        bigint lo, hi, w;
+    };
+    std::vector<Segment> segs;
+    bigint total = 0;
+    for (int n = size_of(start);; ++n) {
+        bigint lo = std::max(start, n ? prefixN[n - 1] : bigint(0));
+        bigint hi = std::min(end, prefixN[n]);
+        segs.push_back({lo, hi, weight(n)});
+        total += (hi - lo) * segs.back().w;
+        if (hi == end)
+            break;
+    }
+
+    bigint target = (total + parts - 1) / parts;
+    bigint acc = 0, begin = start;
+    for (const auto &sg : segs) {
+        bigint at = sg.lo;
+        while (at < sg.hi) {
+            /* indices of this size still fitting in the current chunk */
+            bigint take = (target - acc + sg.w - 1) / sg.w;
+            if (at + take >= sg.hi) {
+                acc += (sg.hi - at) * sg.w;
+                break;
+            }
+            at += take;
+            out.push_back({begin, at});
+            begin = at;
+            acc = 0;
+        }
+    }
+    if (begin < end)
+        out.push_back({begin, end});
+    return out;
+}
+
+void enumerate_chunks(const bigint &start, const bigint &end,
+                      const ChunkSink &sink, const EnumerateOptions &opts) {
+    unsigned threads = opts.threads ? opts.threads
+                                    : std::max(1u, std::thread::hardware_concurrency());
+    auto chunks = split_range(start, end,
+                              std::size_t(threads) * std::max(1u, opts.chunksPerThread));
+    if (chunks.empty())
+        return;
+    threads = unsigned(std::min<std::size_t>(threads, chunks.size()));
+
+    /* one worker, or a call from inside a sink (the pool is busy with the
+     * outer job): walk the chunks right here */
+    if (threads == 1 || t_poolWorker) {
+        std::optional<ExprCursor> cur;
+        for (const auto &c : chunks) {
+            move_to(cur, c);
+            sink(c, *cur, 0);
+        }
+        return;
+    }
+
+    Job job{chunks, sink, threads};
+    WorkerPool::instance().run(job);
+    if (job.error)
+        std::rethrow_exception(job.error);
+}
+
+void enumerate_range(const bigint &start, const bigint &end,
+                     const IndexVisitor &visit, const EnumerateOptions &opts) {
+    enumerate_chunks(
+        start, end,
+        [&](const RangeChunk &c, ExprCursor &cur, unsigned w) {
+            for (bigint left = c.end - c.begin;;) {
+                visit(cur, w);
+                if (--left == 0)
+                    break;
+                cur.next();
+            }
+        },
+        opts);
+}
+
+/* Decodes [start, start+count) chunk by chunk through emit(flat, out) and
+ * joins the chunk strings in index order with sep */
+template <class Emit>
+static std::string emit_range_parallel(const bigint &start, std::size_t count,
+                                       std::string_view open, char sep,
+                                       std::string_view close, Emit emit,
+                                       const EnumerateOptions &opts) {
+    bigint end = std::min<bigint>(start + count, prefixN[size_limit()]);
+    if (start >= end && count)
+        ExprCursor{start}; // out-of-range starts throw as sequentially
+    std::mutex mu;
+    std::map<bigint, std::string> parts;
+    enumerate_chunks(
+        start, end,
+        [&](const RangeChunk &c, ExprCursor &cur, unsigned) {
+            FlatExpr flat;
+            std::string out;
+            for (bigint left = c.end - c.begin;;) {
+                flatten_expr(cur.signature(), cur.ops(), cur.labels(), flat);
+                emit(flat, out);
+                if (--left == 0)
+                    break;
+                out += sep;
+                cur.next();
+            }
+            std::lock_guard lock(mu);
+            parts.emplace(c.begin, std::move(out));
+        },
+        opts);
+
+    std::size_t len = open.size() + close.size() + parts.size();
+    for (const auto &[begin, part] : parts)
+        len += part.size();
+    std::string out(open);
+    out.reserve(len);
+    for (const auto &[begin, part] : parts) {
+        if (begin != start)
+            out += sep;
+        out += part;
+    }
+    out += close;
+    return out;
+}
+
+std::string get_expr_range_parallel(const bigint &start, std::size_t count,
+                                    const EnumerateOptions &opts) {
+    return emit_range_parallel(
+        start, count, "", '\n', "",
+        [](FlatExpr &f, std::string &o) { emit_flat(f, o); }, opts);
+}
+
+std::string get_expr_range_full_parallel(const bigint &start,
+                                         std::size_t count,
+                                         const EnumerateOptions &opts) {
+    return emit_range_parallel(
+        start, count, "[", ',', "]",
+        [](FlatExpr &f, std::string &o) {
+            o += "{\"expr\":\"";
+            emit_flat(f, o);
+            o += "\",\"tree\":";
+            serialise_flat(f, o);
+            o += '}';
+        },
+        opts);
+}
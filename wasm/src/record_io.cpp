@@ -0,0 +1,307 @@
+#include "record_io.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[8] = {'C', 'I', 'R', 'C', 'F', 'R', 'E', 'C'};
+constexpr char kEndMagic[8] = {'C', 'I', 'R', 'C', 'F', 'E', 'N', 'D'};
+constexpr std::size_t kFooterBytes = 24;
+
+template <class T> void put_le(std::vector<char> &out, T v) {
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+        out.push_back(char(v >> (8 * i) & 0xFF));
+}
+
+template <class T> T get_le(const unsigned char *p) {
+    T v = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+        v |= T(p[i]) << (8 * i);
+    return v;
+}
+
+/* Appends bits LSB-first into whole bytes */
+struct BitPacker {
+    std::vector<char> &out;
+    unsigned acc = 0, n = 0;
+
+    void put(unsigned bits, unsigned width) {
+        acc |= bits << n;
+        n += width;
+        while (n >= 8) {
+            out.push_back(char(acc & 0xFF));
+            acc >>= 8;
+            n -= 8;
+        }
+    }
+    void pad() {
+        if (n)
+            out.push_back(char(acc & 0xFF));
+        acc = n = 0;
+    }
+};
+
+void write_all(int fd, const char *p, std::size_t n) {
+    while (n) {
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(std::string("Record write failed: ") +
+                                     std::strerror(errno));
+        }
+        p += w;
+        n -= std::size_t(w);
+    }
+}
+
+} // namespace
+
+RecordWriter::RecordWriter(int fd, const bigint &start, int maxSize,
+                           std::size_t bufferBytes)
+    : fd_(fd), wide_(maxSize >= 256) {
+    if (start < 0)
+        throw std::runtime_error("Record start index must be non-negative");
+    std::vector<char> head(kMagic, kMagic + 8);
+    put_le<std::uint32_t>(head, kRecordVersion);
+    put_le<std::uint32_t>(head, wide_ ? kWideLabels : 0);
+    put_le<std::uint32_t>(head, kRecordStride);
+    std::vector<unsigned char> mag;
+    export_bits(start, std::back_inserter(mag), 8, false);
+    if (start == 0)
+        mag.clear();
+    put_le<std::uint32_t>(head, std::uint32_t(mag.size()));
+    head.insert(head.end(), mag.begin(), mag.end());
+
+    buf_ = std::move(head);
+    used_ = buf_.size();
+    buf_.resize(std::max(bufferBytes, used_ + 4096));
+}
+
+RecordWriter::~RecordWriter() {
+    if (!finished_) {
+        try {
+            finish();
+        } catch (...) {
+        }
+    }
+}
+
+void RecordWriter::flush() {
+    write_all(fd_, buf_.data(), used_);
+    offset_ += used_;
+    used_ = 0;
+}
+
+void RecordWriter::append(const std::string &sig,
+                          const std::vector<std::uint8_t> &ops,
+                          const std::vector<int> &labels) {
+    if (count_ % kRecordStride == 0)
+        index_.push_back(offset_ + used_);
+    ++count_;
+
+    /* worst case: 2 bits per node, 2 bits per op, 2 bytes per label */
+    std::size_t need = sig.size() / 4 + ops.size() / 4 + labels.size() * 2 + 4;
+    if (used_ + need > buf_.size()) {
+        flush();
+        if (need > buf_.size())
+            buf_.resize(need);
+    }
+
+    thread_local std::vector<char> rec;
+    rec.clear();
+    BitPacker bits{rec};
+    for (char t : sig) {
+        if (t == 'L')
+            bits.put(0, 1);
+        else
+            bits.put(t == 'U' ? 1 : 3, 2);
+    }
+    bits.pad();
+    for (auto o : ops)
+        bits.put(o, 2);
+    bits.pad();
+    for (int l : labels) {
+        rec.push_back(char(l & 0xFF));
+        if (wide_)
+            rec.push_back(char(l >> 8 & 0xFF));
+    }
+    std::memcpy(buf_.data() + used_, rec.data(), rec.size());
+    used_ += rec.size();
+}
+
+void RecordWriter::finish() {
+    if (finished_)
+        return;
+    finished_ = true;
+    std::uint64_t indexAt = offset_ + used_;
+    std::vector<char> tail;
+    for (auto off : index_)
+        put_le<std::uint64_t>(tail, off);
+    put_le<std::uint64_t>(tail, count_);
+    put_le<std::uint64_t>(tail, indexAt);
+    tail.insert(tail.end(), kEndMagic, kEndMagic + 8);
+    flush();
+    write_all(fd_, tail.data(), tail.size());
+    offset_ += tail.size();
+}
+
+RecordReader::RecordReader(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open " + path + ": " +
+                                 std::strerror(errno));
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < off_t(24 + kFooterBytes)) {
+        ::close(fd);
+        throw std::runtime_error("Not a record file: " + path);
+    }
+    len_ = std::size_t(st.st_size);
+    void *m = ::mmap(nullptr, len_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED)
+        throw std::runtime_error("Cannot map " + path);
+    data_ = static_cast<const unsigned char *>(m);
+
+    auto reject = [&] {
+        ::munmap(const_cast<unsigned char *>(data_), len_);
+        data_ = nullptr;
+        throw std::runtime_error("Not a record file: " + path);
+    };
+    const unsigned char *foot = data_ + len_ - kFooterBytes;
+    if (std::memcmp(data_, kMagic, 8) != 0 ||
+        std::memcmp(foot + 16, kEndMagic, 8) != 0 ||
+        get_le<std::uint32_t>(data_ + 8) != kRecordVersion)
+        reject();
+    wide_ = get_le<std::uint32_t>(data_ + 12) & kWideLabels;
+    stride_ = get_le<std::uint32_t>(data_ + 16);
+    std::uint64_t first = 24 + std::uint64_t(get_le<std::uint32_t>(data_ + 20));
+    count_ = get_le<std::uint64_t>(foot);
+    std::uint64_t end = get_le<std::uint64_t>(foot + 8);
+
+    /* Every later read stays inside [first, recordsEnd_) or the index, so
+     * the layout is checked once here; the 64-bit sums cannot wrap */
+    const std::uint64_t indexLimit = len_ - kFooterBytes;
+    if (stride_ == 0 || first > end || end > indexLimit)
+        reject();
+    std::uint64_t entries = count_ / stride_ + (count_ % stride_ != 0);
+    if (entries > (indexLimit - end) / 8)
+        reject();
+    recordsEnd_ = std::size_t(end);
+    index_ = data_ + recordsEnd_;
+    for (std::uint64_t i = 0; i < entries; ++i) {
+        std::uint64_t off = get_le<std::uint64_t>(index_ + 8 * i);
+        if (off < first || off >= end)
+            reject();
+    }
+    if (first > 24)
+        import_bits(start_, data_ + 24, data_ + first, 8, false);
+    at_ = std::size_t(first);
+}
+
+RecordReader::~RecordReader() {
+    if (data_)
+        ::munmap(const_cast<unsigned char *>(data_), len_);
+}
+
+unsigned char RecordReader::byte(std::size_t off) const {
+    if (off >= recordsEnd_)
+        throw std::runtime_error("Corrupt record file");
+    return data_[off];
+}
+
+/* Offset just past the record at off */
+std::size_t RecordReader::skip(std::size_t off) const {
+    int need = 1, s = 0, b = 0;
+    unsigned bit = 0;
+    auto next_bit = [&] {
+        unsigned v = byte(off + bit / 8) >> (bit % 8) & 1;
+        ++bit;
+        return v;
+    };
+    while (need) {
+        if (!next_bit()) {
+            ++s;
+            --need;
+        } else if (next_bit()) {
+            ++b;
+            ++need;
+        }
+    }
+    off += (bit + 7) / 8 + (2 * b + 7) / 8 + std::size_t(s) * (wide_ ? 2 : 1);
+    if (off > recordsEnd_)
+        throw std::runtime_error("Corrupt record file");
+    return off;
+}
+
+std::size_t RecordReader::decode(std::size_t off, ExprRecord &out) const {
+    out.sig.clear();
+    int need = 1;
+    unsigned bit = 0;
+    auto next_bit = [&] {
+        unsigned v = byte(off + bit / 8) >> (bit % 8) & 1;
+        ++bit;
+        return v;
+    };
+    while (need) {
+        if (!next_bit()) {
+            out.sig += 'L';
+            --need;
+        } else if (next_bit()) {
+            out.sig += 'B';
+            ++need;
+        } else {
+            out.sig += 'U';
+        }
+    }
+    off += (bit + 7) / 8;
+
+    std::size_t b = std::count(out.sig.begin(), out.sig.end(), 'B');
+    out.ops.resize(b);
+    for (std::size_t i = 0; i < b; ++i)
+        out.ops[i] = byte(off + i / 4) >> (2 * (i % 4)) & 3;
+    off += (2 * b + 7) / 8;
+
+    out.labels.resize(b + 1);
+    for (auto &l : out.labels) {
+        l = byte(off++);
+        if (wide_)
+            l |= int(byte(off++)) << 8;
+    }
+    return off;
+}
+
+void RecordReader::seek(std::uint64_t k) {
+    if (k > count_)
+        throw std::runtime_error("Record out of range");
+    pos_ = k;
+    if (k == count_) {
+        at_ = recordsEnd_;
+        return;
+    }
+    at_ = std::size_t(get_le<std::uint64_t>(index_ + 8 * (k / stride_)));
+    for (std::uint64_t i = k % stride_; i > 0; --i)
+        at_ = skip(at_);
+}
+
+bool RecordReader::next(ExprRecord &out) {
+    if (pos_ >= count_)
+        return false;
+    at_ = decode(at_, out);
+    ++pos_;
+    return true;
+}
+
+ExprRecord RecordReader::read(std::uint64_t k) {
+    ExprRecord r;
+    seek(k);
+    if (!next(r))
+        throw std::runtime_error("Record out of range");
+    return r;
+}
@@ -0,0 +1,118 @@
+#include "sampler.h"
+#include "compute_data.h"
+#include "tiered.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr int kOpDigits = 40;
+constexpr std::uint64_t kOpRadix = 12157665459056928801ULL; // 3^40
+
+/* First n with prefixN[n] > r */
+int size_of(const bigint &r) {
+    int lo = 0, hi = size_limit();
+    while (lo < hi) {
+        int m = (lo + hi) / 2;
+        (prefixN[m] > r) ? hi = m : lo = m + 1;
+    }
+    return lo;
+}
+
+/* Leaf count of the size-n block holding offset r */
+int leaves_of(int n, const bigint &r) {
+    const auto &start = size_layer(n).BlockStart;
+    return int(std::upper_bound(start.begin() + 1, start.end(), r) -
+               start.begin());
+}
+
+} // namespace
+
+ExprSampler::ExprSampler(std::uint64_t seed) : rng_(seed) {}
+
+/* Rejection sampling on the bit length of bound: under two tries on
+ * average */
+bigint ExprSampler::below(const bigint &bound) {
+    if (bound <= 0)
+        throw std::runtime_error("Sample bound must be positive");
+    unsigned bits = unsigned(msb(bound)) + 1;
+    unsigned top = bits % 64;
+    std::uint64_t mask = top ? (std::uint64_t(1) << top) - 1 : ~0ULL;
+    if (bits <= 64) {
+        auto b = bound.convert_to<std::uint64_t>();
+        for (;;)
+            if (std::uint64_t v = rng_() & mask; v < b)
+                return v;
+    }
+    words_.resize((bits + 63) / 64);
+    for (bigint x;;) {
+        for (auto &w : words_)
+            w = rng_();
+        words_.back() &= mask;
+        import_bits(x, words_.begin(), words_.end(), 64, false);
+        if (x < bound)
+            return x;
+    }
+}
+
+void ExprSampler::sample_block(int s, int u, ExprRecord &out) {
+    tiered::dispatch(below(C[s][u]), [&](const auto &k) {
+        tiered::unrank_shape_into(s, u, k, out.sig);
+    });
+
+    /* operator digits 40 at a time from a word below 3^40 */
+    out.ops.resize(std::size_t(s - 1));
+    for (std::size_t i = 0; i < out.ops.size();) {
+        std::uint64_t w;
+        do
+            w = rng_();
+        while (w >= kOpRadix);
+        std::size_t end = std::min(out.ops.size(), i + kOpDigits);
+        for (; i < end; ++i, w /= 3)
+            out.ops[i] = std::uint8_t(w % 3);
+    }
+
+    out.labels = unrank_rgs(s, below(Bell[s]));
+}
+
+void ExprSampler::sample(const SampleSpec &spec, ExprRecord &out) {
+    int n = spec.n, s = spec.s;
+    if (n < 0) {
+        if (s)
+            throw std::runtime_error("A leaf count needs a size");
+        n = size_of(below(prefixN[size_limit()]));
+    } else if (n > size_limit()) {
+        throw std::runtime_error("Size " + std::to_string(n) +
+                                 " exceeds the size limit (" +
+                                 std::to_string(size_limit()) + ")");
+    }
+    if (s == 0)
+        s = leaves_of(n, below(Wn[n]));
+    else if (s < 1 || s > n + 1)
+        throw std::runtime_error("Leaf count out of range for size " +
+                                 std::to_string(n));
+    sample_block(s, n - s + 1, out);
+}
+
+void ExprSampler::sample_batch(const SampleSpec &spec, std::size_t count,
+                               std::vector<ExprRecord> &out) {
+    out.resize(count);
+    for (auto &r : out)
+        sample(spec, r);
+}
+
+void ExprSampler::sample_batch(const SampleSpec &spec, std::size_t count,
+                               FlatBatch &out) {
+    out.nodes.clear();
+    out.vars.clear();
+    out.start.assign(1, 0);
+    for (std::size_t i = 0; i < count; ++i) {
+        sample(spec, scratch_);
+        flatten_expr(scratch_.sig, scratch_.ops, scratch_.labels, flat_);
+        out.nodes.insert(out.nodes.end(), flat_.nodes.begin(),
+                         flat_.nodes.end());
+        out.start.push_back(std::uint32_t(out.nodes.size()));
+        out.vars.push_back(flat_.vars);
+    }
+}
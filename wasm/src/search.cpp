@@ -0,0 +1,514 @@
+#include "search.h"
+#include "compute_data.h"
+#include <algorithm>
+#include <bit>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+/* Truth table over at most kMaxSearchVars variables, one bit per row */
+using Fn = std::uint32_t;
+
+constexpr unsigned kAllOps = 7;           // AND, OR and XOR allowed
+constexpr double kExactWork = 1 << 20;    // beyond this, bound a product
+constexpr std::size_t kMemoBytes = 64 << 20;
+
+/* Variable patterns within a table (low 2^vars bits are used) */
+constexpr Fn kVarMask[kMaxSearchVars] = {0xAAAA, 0xCCCC, 0xF0F0, 0xFF00};
+
+std::uint64_t cap(const bigint &x) {
+    constexpr auto kMax = std::numeric_limits<std::uint64_t>::max();
+    return x > kMax ? kMax : x.convert_to<std::uint64_t>();
+}
+
+std::uint64_t mul_cap(std::uint64_t a, std::uint64_t b) {
+    constexpr auto kMax = std::numeric_limits<std::uint64_t>::max();
+    return b && a > kMax / b ? kMax : a * b;
+}
+
+/* Length of the subtree starting at sig[pos] */
+std::size_t subtree_len(std::string_view sig, std::size_t pos) {
+    std::size_t i = pos;
+    for (int need = 1; need; ++i)
+        need += sig[i] == 'B' ? 1 : sig[i] == 'L' ? -1 : 0;
+    return i - pos;
+}
+
+/* Set of functions: bit f is set when the function with table f is in */
+class FnSet {
+  public:
+    FnSet() = default;
+    explicit FnSet(std::size_t universe)
+        : bits_(std::max<std::size_t>(1, universe / 64)) {}
+
+    bool has(Fn f) const { return bits_[f >> 6] >> (f & 63) & 1; }
+    void add(Fn f) { bits_[f >> 6] |= std::uint64_t(1) << (f & 63); }
+
+    std::size_t count() const {
+        std::size_t c = 0;
+        for (std::uint64_t w : bits_)
+            c += std::size_t(std::popcount(w));
+        return c;
+    }
+
+    template <class F> void each(F &&f) const {
+        for (std::size_t i = 0; i < bits_.size(); ++i)
+            for (std::uint64_t w = bits_[i]; w; w &= w - 1)
+                f(Fn(i * 64 + std::size_t(std::countr_zero(w))));
+    }
+
+    std::vector<Fn> members() const {
+        std::vector<Fn> out;
+        out.reserve(count());
+        each([&](Fn f) { out.push_back(f); });
+        return out;
+    }
+
+    FnSet &operator|=(const FnSet &o) {
+        for (std::size_t i = 0; i < bits_.size(); ++i)
+            bits_[i] |= o.bits_[i];
+        return *this;
+    }
+
+  private:
+    std::vector<std::uint64_t> bits_;
+};
+
+/* One search over a fixed variable count. Functions live in the
+ * 2^(2^vars) universe of tables over those variables; leaves may carry any
+ * of them, so every set below over-approximates what restricted growth
+ * labelings can reach and is safe for pruning. */
+class Engine {
+  public:
+    explicit Engine(int vars)
+        : vars_(vars), rows_(1 << vars), universe_(std::size_t(1) << rows_),
+          full_(Fn(universe_ - 1)), leaves_(universe_),
+          memoLimit_(std::max<std::size_t>(
+              64, kMemoBytes / (std::max<std::size_t>(8, universe_ / 8) +
+                                64))) {
+        for (int v = 0; v < vars; ++v)
+            leaves_.add(kVarMask[v] & full_);
+    }
+
+    std::optional<bigint> run(Fn target, int maxSize) {
+        target_ = target;
+        maxSize = std::min(maxSize, size_limit());
+        for (int n = 0; n <= maxSize; ++n) {
+            if (!exact(n).has(target))
+                continue;
+            for (int s = vars_; s <= n + 1; ++s)
+                if (walk(s, n - s + 1, target, cap(C[s][n - s + 1])))
+                    return found_;
+        }
+        return std::nullopt;
+    }
+
+  private:
+    /* Functions reachable at exactly size m */
+    const FnSet &exact(int m) {
+        while (int(exact_.size()) <= m) {
+            int k = int(exact_.size());
+            if (k == 0) {
+                exact_.push_back(leaves_);
+                continue;
+            }
+            FnSet e = negate(exact_[std::size_t(k - 1)]);
+            for (int a = 0; a < k; ++a)
+                e |= pair_set(a, k - 1 - a);
+            exact_.push_back(std::move(e));
+        }
+        return exact_[std::size_t(m)];
+    }
+
+    /* Functions of a binary node whose children have sizes a and b */
+    const FnSet &pair_set(int a, int b) {
+        auto it = pairs_.find({a, b});
+        if (it == pairs_.end())
+            it = pairs_.emplace(std::pair{a, b},
+                                combine(exact(a), exact(b), kAllOps))
+                     .first;
+        return it->second;
+    }
+
+    FnSet negate(const FnSet &a) const {
+        FnSet out(universe_);
+        a.each([&](Fn f) { out.add(f ^ full_); });
+        return out;
+    }
+
+    /* {f op g} over the allowed ops. Small sets are multiplied pairwise;
+     * large ones through the zeta (AND: supersets, OR: subsets) or
+     * Walsh–Hadamard (XOR) transform of their indicator vectors, where the
+     * pointwise product counts the pairs meeting at each function. When
+     * even that is too costly and `bound` is given, returns *bound. */
+    FnSet combine(const FnSet &a, const FnSet &b, unsigned ops,
+                  const FnSet *bound = nullptr) const {
+        double pairs = double(a.count()) * double(b.count());
+        double dense = 3.0 * rows_ * double(universe_);
+        if (bound && std::min(pairs, dense) > kExactWork)
+            return *bound;
+
+        FnSet out(universe_);
+        if (pairs <= dense) {
+            auto ma = a.members(), mb = b.members();
+            for (Fn f : ma)
+                for (Fn g : mb) {
+                    if (ops & 1)
+                        out.add(f & g);
+                    if (ops & 2)
+                        out.add(f | g);
+                    if (ops & 4)
+                        out.add(f ^ g);
+                }
+            return out;
+        }
+
+        std::vector<std::int64_t> x(universe_), y(universe_);
+        for (unsigned op = 0; op < 3; ++op) {
+            if (!(ops >> op & 1))
+                continue;
+            std::fill(x.begin(), x.end(), 0);
+            std::fill(y.begin(), y.end(), 0);
+            a.each([&](Fn f) { x[f] = 1; });
+            b.each([&](Fn f) { y[f] = 1; });
+            transform(x, op, false);
+            transform(y, op, false);
+            for (std::size_t i = 0; i < universe_; ++i)
+                x[i] *= y[i];
+            transform(x, op, true);
+            for (std::size_t i = 0; i < universe_; ++i)
+                if (x[i])
+                    out.add(Fn(i));
+        }
+        return out;
+    }
+
+    void transform(std::vector<std::int64_t> &x, unsigned op,
+                   bool inverse) const {
+        for (int j = 0; j < rows_; ++j) {
+            std::size_t bit = std::size_t(1) << j;
+            for (std::size_t i = 0; i < universe_; ++i) {
+                if (i & bit)
+                    continue;
+                std::int64_t &lo = x[i], &hi = x[i | bit];
+                if (op == 2) {
+                    std::int64_t l = lo;
+                    lo = l + hi;
+                    hi = l - hi;
+                } else if (op == 0) {
+                    lo += inverse ? -hi : hi;
+                } else {
+                    hi += inverse ? -lo : lo;
+                }
+            }
+        }
+        /* the inverse Walsh–Hadamard transform would divide by the
+         * universe size; only zero versus non-zero matters here */
+    }
+
+    /* Whether f op g = t for some f in a, g in b; unsure counts as yes */
+    bool can_make(Fn t, const FnSet &a, const FnSet &b) const {
+        bool hit = false;
+        a.each([&](Fn f) { hit = hit || b.has(f ^ t); });
+        if (hit)
+            return true;
+        std::vector<Fn> up, down, bu, bd; // ⊇ t for AND, ⊆ t for OR
+        auto split = [t](const FnSet &set, std::vector<Fn> &sup,
+                         std::vector<Fn> &sub) {
+            set.each([&](Fn f) {
+                if ((f & t) == t)
+                    sup.push_back(f);
+                if ((f & ~t) == 0)
+                    sub.push_back(f);
+            });
+        };
+        split(a, up, down);
+        split(b, bu, bd);
+        if (double(up.size()) * double(bu.size()) +
+                double(down.size()) * double(bd.size()) >
+            kExactWork)
+            return true;
+        for (Fn f : up)
+            for (Fn g : bu)
+                if ((f & g) == t)
+                    return true;
+        for (Fn f : down)
+            for (Fn g : bd)
+                if ((f | g) == t)
+                    return true;
+        return false;
+    }
+
+    /* Functions a shape reaches with any operators and labels (memoised
+     * per subtree; the memo is dropped wholesale when full) */
+    FnSet reach(std::string_view sig) {
+        std::string key(sig);
+        if (auto it = memo_.find(key); it != memo_.end())
+            return it->second;
+        FnSet r;
+        if (sig[0] == 'L') {
+            r = leaves_;
+        } else if (sig[0] == 'U') {
+            r = negate(reach(sig.substr(1)));
+        } else {
+            std::size_t l = subtree_len(sig, 1);
+            auto left = sig.substr(1, l), right = sig.substr(1 + l);
+            r = combine(reach(left), reach(right), kAllOps,
+                        &pair_set(size_of(left), size_of(right)));
+        }
+        if (memo_.size() >= memoLimit_)
+            memo_.clear();
+        memo_.emplace(std::move(key), r);
+        return r;
+    }
+
+    static int size_of(std::string_view sig) {
+        return int(sig.size() - std::size_t(std::count(sig.begin(),
+                                                        sig.end(), 'L')));
+    }
+
+    /* Every shape of (s, u) in rank order, truncated to the first C[s][u]
+     * like unrank_shape; stops once f returns true and reports that */
+    bool each_shape(int s, int u,
+                    const std::function<bool(const std::string &)> &f) {
+        if (s == 1)
+            return f(std::string(std::size_t(u), 'U') + 'L');
+        std::uint64_t left = cap(C[s][u]);
+        if (!left)
+            return false;
+        bool found = false;
+        auto emit = [&](const std::string &sig) {
+            found = f(sig);
+            return found || --left == 0;
+        };
+        if (u && each_shape(s, u - 1, [&](const std::string &c) {
+                return emit('U' + c);
+            }))
+            return found;
+        for (int ls = 1; ls < s; ++ls)
+            for (int u1 = 0; u1 <= u; ++u1) {
+                int rs = s - ls, ur = u - u1;
+                if (each_shape(ls, u1, [&](const std::string &l) {
+                        return each_shape(rs, ur, [&](const std::string &r) {
+                            return emit('B' + l + r);
+                        });
+                    }))
+                    return found;
+            }
+        return false;
+    }
+
+    /* The shapes of (s, u) with rank below `budget` whose root must
+     * compute t, in rank order: unary roots first (the child must compute
+     * ¬t), then the splits, each skipped unless its sizes can meet at t,
+     * then left subtrees skipped unless some right subtree of that size
+     * can complete t. Complete candidates go to try_shape. */
+    bool walk(int s, int u, Fn t, std::uint64_t budget) {
+        if (!budget || !exact(s - 1 + u).has(t))
+            return false;
+        if (s == 1)
+            return try_shape(prefix_ + std::string(std::size_t(u), 'U') + 'L');
+
+        std::uint64_t base = 0;
+        if (u) {
+            std::uint64_t span = cap(C[s][u - 1]);
+            prefix_ += 'U';
+            bool hit = walk(s, u - 1, t ^ full_, std::min(span, budget));
+            prefix_.pop_back();
+            if (hit)
+                return true;
+            base = span;
+        }
+        for (int ls = 1; ls < s; ++ls)
+            for (int u1 = 0; u1 <= u; ++u1) {
+                if (base >= budget)
+                    return false;
+                int rs = s - ls, ur = u - u1;
+                std::uint64_t rspan = cap(C[rs][ur]);
+                std::uint64_t span = mul_cap(cap(C[ls][u1]), rspan);
+                int a = ls - 1 + u1, b = rs - 1 + ur;
+                if (pair_set(a, b).has(t) &&
+                    walk_split(ls, u1, rs, ur, t, base, rspan, budget))
+                    return true;
+                base = span > budget - base ? budget : base + span;
+            }
+        return false;
+    }
+
+    bool walk_split(int ls, int u1, int rs, int ur, Fn t, std::uint64_t base,
+                    std::uint64_t rspan, std::uint64_t budget) {
+        const FnSet &rightSizes = exact(rs - 1 + ur);
+        std::uint64_t leftRank = 0;
+        bool found = false;
+        each_shape(ls, u1, [&](const std::string &l) {
+            std::uint64_t first = base + mul_cap(leftRank++, rspan);
+            if (first >= budget)
+                return true;
+            FnSet lr = reach(l);
+            if (!can_make(t, lr, rightSizes))
+                return false;
+            std::uint64_t rightRank = 0;
+            return each_shape(rs, ur, [&](const std::string &r) {
+                if (first + rightRank++ >= budget)
+                    return true;
+                if (!can_make(t, lr, reach(r)))
+                    return false;
+                found = try_shape(prefix_ + 'B' + l + r);
+                return found;
+            });
+        });
+        return found;
+    }
+
+    /* Operator digits from the most significant (the last binary node in
+     * preorder) down, each the smallest one some completion still allows;
+     * then the labels */
+    bool try_shape(const std::string &sig) {
+        sig_ = sig;
+        ops_.assign(std::size_t(std::count(sig.begin(), sig.end(), 'B')), 0);
+        return assign_op(int(ops_.size()));
+    }
+
+    bool assign_op(int fixedFrom) {
+        if (fixedFrom == 0)
+            return assign_labels();
+        int i = fixedFrom - 1;
+        for (std::uint8_t d = 0; d < 3; ++d) {
+            ops_[std::size_t(i)] = d;
+            std::size_t pos = 0;
+            int bin = 0;
+            if (partial(pos, bin, i).has(target_) && assign_op(i))
+                return true;
+        }
+        return false;
+    }
+
+    /* Reachable set of the subtree at pos when binary nodes fixedFrom… use
+     * their digits and the rest are free */
+    FnSet partial(std::size_t &pos, int &bin, int fixedFrom) {
+        std::string_view sig = sig_;
+        std::size_t len = subtree_len(sig, pos);
+        auto sub = sig.substr(pos, len);
+        int binaries = int(std::count(sub.begin(), sub.end(), 'B'));
+        if (binaries == 0 || bin + binaries <= fixedFrom) {
+            pos += len;
+            bin += binaries;
+            return reach(sub);
+        }
+        char c = sig[pos++];
+        if (c == 'U')
+            return negate(partial(pos, bin, fixedFrom));
+        int me = bin++;
+        auto leftSub = sig.substr(pos, subtree_len(sig, pos));
+        FnSet l = partial(pos, bin, fixedFrom);
+        auto rightSub = sig.substr(pos, subtree_len(sig, pos));
+        FnSet r = partial(pos, bin, fixedFrom);
+        unsigned ops = me >= fixedFrom ? 1u << ops_[std::size_t(me)] : kAllOps;
+        return combine(l, r, ops,
+                       &pair_set(size_of(leftSub), size_of(rightSub)));
+    }
+
+    /* Restricted growth labelings with exactly vars_ labels, in rank
+     * (lexicographic) order */
+    bool assign_labels() {
+        int s = int(std::count(sig_.begin(), sig_.end(), 'L'));
+        labels_.assign(std::size_t(s), 0);
+        return label_from(0, -1, s);
+    }
+
+    bool label_from(int i, int top, int s) {
+        if (i == s) {
+            if (top != vars_ - 1 || eval() != target_)
+                return false;
+            bigint opIdx = 0;
+            for (std::size_t j = ops_.size(); j-- > 0;)
+                opIdx = opIdx * 3 + ops_[j];
+            found_ = rank_expr_components(sig_, opIdx, labels_);
+            return true;
+        }
+        for (int v = 0; v <= std::min(top + 1, vars_ - 1); ++v) {
+            int next = std::max(top, v);
+            if (s - i - 1 < vars_ - 1 - next)
+                continue;
+            labels_[std::size_t(i)] = v;
+            if (label_from(i + 1, next, s))
+                return true;
+        }
+        return false;
+    }
+
+    /* Packed evaluation, right to left as in truth_table() */
+    Fn eval() {
+        stack_.clear();
+        std::size_t lp = labels_.size(), op = ops_.size();
+        for (std::size_t i = sig_.size(); i-- > 0;) {
+            char c = sig_[i];
+            if (c == 'L') {
+                stack_.push_back(kVarMask[labels_[--lp]] & full_);
+            } else if (c == 'U') {
+                stack_.back() ^= full_;
+            } else {
+                Fn a = stack_.back();
+                stack_.pop_back();
+                Fn &r = stack_.back();
+                switch (ops_[--op]) {
+                case 0:
+                    r = a & r;
+                    break;
+                case 1:
+                    r = a | r;
+                    break;
+                default:
+                    r = a ^ r;
+                    break;
+                }
+            }
+        }
+        return stack_.back();
+    }
+
+    int vars_, rows_;
+    std::size_t universe_;
+    Fn full_, target_ = 0;
+    FnSet leaves_;
+    std::deque<FnSet> exact_;
+    std::map<std::pair<int, int>, FnSet> pairs_;
+    std::unordered_map<std::string, FnSet> memo_;
+    std::size_t memoLimit_;
+
+    std::string prefix_, sig_;
+    std::vector<std::uint8_t> ops_;
+    std::vector<int> labels_;
+    std::vector<Fn> stack_;
+    bigint found_;
+};
+
+} // namespace
+
+std::optional<bigint> find_min_index(int vars, std::uint64_t mask,
+                                     const SearchOptions &opts) {
+    if (vars < 1 || vars > kMaxSearchVars)
+        throw std::runtime_error("Search targets need 1…" +
+                                 std::to_string(kMaxSearchVars) +
+                                 " variables");
+    std::uint64_t full = (std::uint64_t(1) << (1u << vars)) - 1;
+    if (mask & ~full)
+        throw std::runtime_error("Target mask has bits beyond its " +
+                                 std::to_string(1u << vars) + " rows");
+    return Engine(vars).run(Fn(mask), opts.maxSize);
+}
+
+std::optional<bigint> find_min_index(const TruthTable &target,
+                                     const SearchOptions &opts) {
+    if (target.words.size() != 1)
+        throw std::runtime_error("Search targets need 1…" +
+                                 std::to_string(kMaxSearchVars) +
+                                 " variables");
+    return find_min_index(target.vars, target.words[0], opts);
+}
@@ -0,0 +1,382 @@
+#include "tiered.h"
+#include "compute.h"
+#include "instrument.h"
+#include "kernels.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace tiered {
+
+namespace {
+
+/* Multiplies, saturating at the tier maximum */
+template <class Int> Int sat_mul(const Int &a, const Int &b) {
+    if constexpr (std::is_same_v<Int, u64> || std::is_same_v<Int, u128>) {
+        Int r;
+        return __builtin_mul_overflow(a, b, &r) ? ~Int(0) : r;
+    } else if constexpr (std::is_same_v<Int, u1024>) {
+        if (a == 0 || b == 0)
+            return 0;
+        unsigned bits = unsigned(msb(a)) + unsigned(msb(b)) + 2;
+        if (bits <= 1024)
+            return a * b;
+        if (bits > 1025)
+            return ~Int(0);
+        /* a·b = 2·(a/2)·b + (a&1)·b, where (a/2)·b cannot wrap */
+        Int h = (a >> 1) * b;
+        if (h != 0 && msb(h) >= 1023)
+            return ~Int(0);
+        Int r = h << 1;
+        if (a & 1) {
+            r += b;
+            if (r < b)
+                return ~Int(0);
+        }
+        return r;
+    } else {
+        return a * b;
+    }
+}
+
+/* Adds, saturating at the tier maximum */
+template <class Int> Int sat_add(const Int &a, const Int &b) {
+    if constexpr (std::is_same_v<Int, u64> || std::is_same_v<Int, u128>) {
+        Int r;
+        return __builtin_add_overflow(a, b, &r) ? ~Int(0) : r;
+    } else if constexpr (std::is_same_v<Int, u1024>) {
+        Int r = a + b;
+        return r < a ? ~Int(0) : r;
+    } else {
+        return a + b;
+    }
+}
+
+/* Counts cpp_int operations for the instrumented build; fixed-width tiers
+ * are not counted */
+template <class Int> void count_ops(std::uint64_t n) {
+    if constexpr (std::is_same_v<Int, bigint>)
+        CIRC_COUNT(BigintOps, n);
+    (void)n;
+}
+
+/* Reads one generated entry, saturating at the tier maximum */
+template <class Int> Int from_limbs(LimbSpan v) {
+    constexpr unsigned width = std::is_same_v<Int, u64>    ? 1
+                               : std::is_same_v<Int, u128> ? 2
+                                                           : 16;
+    if (v.len > width)
+        return ~Int(0);
+    Int r = 0;
+    if constexpr (width == 1) {
+        r = v.len ? v.limbs[0] : 0;
+    } else if constexpr (width == 2) {
+        for (unsigned i = v.len; i-- > 0;)
+            r = r << 64 | v.limbs[i];
+    } else if (v.len) {
+        import_bits(r, v.limbs, v.limbs + v.len, 64, false);
+    }
+    return r;
+}
+
+template <class Int> void build_layer(int n, SizeLayer<Int> &L);
+template <class Int> constinit Layers<SizeLayer<Int>> g_layers{build_layer<Int>};
+
+/* Saturated copy of layer n: straight from the generated limbs where they
+ * exist, otherwise narrowed from the bigint layer. The derived products
+ * are recomputed in the tier so that they saturate too. */
+template <class Int> void build_layer(int n, SizeLayer<Int> &L) {
+    L.C.resize(n + 1);
+    L.DP_RGS.resize(n + 2);
+    if (n <= table_limbs::size()) {
+        L.Pow3 = from_limbs<Int>(table_limbs::Pow3(n));
+        L.Bell = from_limbs<Int>(table_limbs::Bell(n));
+        L.Wn = from_limbs<Int>(table_limbs::Wn(n));
+        L.prefixN = from_limbs<Int>(table_limbs::prefixN(n));
+        for (int i = 0; i <= n; ++i)
+            L.C[i] = from_limbs<Int>(table_limbs::C(n, i));
+        for (int l = 0; l <= n + 1; ++l)
+            L.DP_RGS[l] = from_limbs<Int>(table_limbs::DP_RGS(n, l));
+    } else {
+        const auto &B = size_layer(n);
+        L.Pow3 = narrow<Int>(B.Pow3);
+        L.Bell = narrow<Int>(B.Bell);
+        L.Wn = narrow<Int>(B.Wn);
+        L.prefixN = narrow<Int>(B.prefixN);
+        for (int i = 0; i <= n; ++i)
+            L.C[i] = narrow<Int>(B.C[i]);
+        for (int l = 0; l <= n + 1; ++l)
+            L.DP_RGS[l] = narrow<Int>(B.DP_RGS[l]);
+    }
+
+    L.ShapeSpan = sat_mul(L.Pow3, L.Bell);
+    L.BlockStart.assign(n + 2, Int(0));
+    for (int j = 0; j <= n; ++j) {
+        const Int &span = j == n ? L.ShapeSpan : g_layers<Int>.at(j).ShapeSpan;
+        L.BlockStart[j + 1] = sat_add(L.BlockStart[j], sat_mul(L.C[j], span));
+    }
+    L.RGSReuse.resize(n + 2);
+    for (int l = 0; l <= n + 1; ++l)
+        L.RGSReuse[l] = sat_mul(L.DP_RGS[l], Int(n + 2 - l));
+}
+
+/* Cumulative split counts for the binary-rooted shapes with s leaves and
+ * u unary nodes. Split j is (ls, u1) = (1 + j / (u+1), j % (u+1)) in the
+ * order unrank_shape enumerates them, and cum[j] counts the shapes of all
+ * earlier splits, so cum has (s-1)(u+1) + 1 entries. Like C(s, u) a table
+ * lives in size layer s-1+u; it is built the first time the pair is
+ * reached rather than with the layer, since a layer's pairs together hold
+ * O(n³) entries and a query touches only a handful of them. */
+template <class Int> struct SplitLayer {
+    std::unique_ptr<std::atomic<const std::vector<Int> *>[]> slots;
+    mutable std::vector<std::unique_ptr<std::vector<Int>>> owned; // under mu
+    mutable std::mutex mu;
+};
+
+template <class Int> void build_split_layer(int n, SplitLayer<Int> &L) {
+    L.slots.reset(new std::atomic<const std::vector<Int> *>[n + 1]{});
+}
+
+template <class Int>
+constinit Layers<SplitLayer<Int>> g_splits{build_split_layer<Int>};
+
+} // namespace
+
+template <class Int> const std::vector<Int> &split_table(int s, int u) {
+    const SplitLayer<Int> &L = g_splits<Int>.at(s - 1 + u);
+    auto &slot = L.slots[std::size_t(s - 1)];
+    if (const auto *t = slot.load(std::memory_order_acquire))
+        return *t;
+
+    using T = Tables<Int>;
+    auto cum = std::make_unique<std::vector<Int>>();
+    cum->reserve(std::size_t((s - 1) * (u + 1) + 1));
+    cum->push_back(Int(0));
+    for (int ls = 1; ls < s; ++ls)
+        for (int u1 = 0; u1 <= u; ++u1)
+            cum->push_back(sat_add(
+                cum->back(), sat_mul(T::C(ls, u1), T::C(s - ls, u - u1))));
+
+    std::lock_guard lock(L.mu);
+    if (const auto *t = slot.load(std::memory_order_relaxed))
+        return *t; // built by another thread meanwhile
+    slot.store(cum.get(), std::memory_order_release);
+    L.owned.push_back(std::move(cum));
+    return *L.owned.back();
+}
+
+template <class Int> const SizeLayer<Int> &layer(int n) {
+    if constexpr (std::is_same_v<Int, bigint>)
+        return size_layer(n);
+    else
+        return g_layers<Int>.at(n);
+}
+
+template <class Int> int built_sizes() {
+    if constexpr (std::is_same_v<Int, bigint>)
+        return ::built_sizes();
+    else
+        return g_layers<Int>.built();
+}
+
+/* Unranks a restricted growth string (used for variable partitioning).
+ * The next label is one of the cur + 1 already used, each followed by
+ * DP_RGS(rest, cur) strings, or the new label cur + 1; so the choice is
+ * one comparison against RGSReuse and, for a reused label, a division */
+template <class Int> std::vector<int> unrank_rgs(int len, Int k) {
+    CIRC_PHASE(UnrankRgs);
+    using T = Tables<Int>;
+    std::vector<int> r(len);
+    int cur = 0;
+    for (int i = 0; i < len; ++i) {
+        int rest = len - i - 1;
+        const Int &reuse = T::RGSReuse(rest, cur);
+        count_ops<Int>(1);
+        if (k < reuse) {
+            const Int &cnt = T::DP_RGS(rest, cur);
+            Int v = k / cnt;
+            k %= cnt;
+            r[i] = int(v);
+            count_ops<Int>(2);
+        } else {
+            k -= reuse;
+            r[i] = ++cur;
+            count_ops<Int>(1);
+        }
+    }
+    return r;
+}
+
+/* Unranks a shape (preorder string of L/U/B) given leaf/unary count */
+template <class Int> std::string unrank_shape(int s, int u, Int k) {
+    std::string sig;
+    unrank_shape_into<Int>(s, u, std::move(k), sig);
+    return sig;
+}
+
+/* Preorder walk with the pending right subtrees on a stack: a U root is
+ * taken while k is below C(s, u-1), otherwise the split is the last entry
+ * of the cumulative table not above k */
+template <class Int>
+void unrank_shape_into(int s, int u, Int k, std::string &sig) {
+    using T = Tables<Int>;
+    struct Pending {
+        int s, u;
+        Int k;
+    };
+    thread_local std::vector<Pending> stack;
+    stack.clear();
+    sig.assign(std::size_t(2 * s + u - 1), 'L');
+    std::size_t pos = 0;
+    for (;;) {
+        if (s == 1) {
+            std::fill_n(sig.begin() + std::ptrdiff_t(pos), u, 'U');
+            pos += std::size_t(u) + 1; // the leaf is already 'L'
+            if (stack.empty())
+                return;
+            s = stack.back().s;
+            u = stack.back().u;
+            k = std::move(stack.back().k);
+            stack.pop_back();
+            continue;
+        }
+        if (u) {
+            const Int &c = T::C(s, u - 1);
+            count_ops<Int>(1);
+            if (k < c) {
+                sig[pos++] = 'U';
+                --u;
+                continue;
+            }
+            k -= c;
+            count_ops<Int>(1);
+        }
+        const auto &cum = split_table<Int>(s, u);
+        std::size_t j =
+            std::size_t(std::upper_bound(cum.begin() + 1, cum.end(), k) -
+                        cum.begin()) -
+            1;
+        count_ops<Int>(std::size_t(std::bit_width(cum.size())) + 1);
+        k -= cum[j];
+        int ls = 1 + int(j) / (u + 1), u1 = int(j) % (u + 1);
+        int rs = s - ls, ru = u - u1;
+        const Int &rc = T::C(rs, ru);
+        count_ops<Int>(2);
+        sig[pos++] = 'B';
+        stack.push_back({rs, ru, k % rc});
+        k /= rc;
+        s = ls;
+        u = u1;
+    }
+}
+
+/* Splits opIdx into one base-3 digit per binary node (preorder). The wide
+ * index is divided once per 40 digits, by 3^40 (the largest power of 3
+ * in a u64); the digits of each chunk then come from word arithmetic
+ * (kernels::base3_digits). */
+template <class Int>
+std::vector<std::uint8_t> decode_ops(const std::string &sig, Int opIdx) {
+    CIRC_PHASE(DecodeOps);
+    constexpr int kDigits = 40;
+    constexpr u64 kRadix = 12157665459056928801ULL; // 3^40
+    std::vector<std::uint8_t> ops(std::count(sig.begin(), sig.end(), 'B'));
+    for (std::size_t i = 0; i < ops.size() && opIdx != 0;) {
+        u64 chunk;
+        if constexpr (std::is_same_v<Int, u64> || std::is_same_v<Int, u128>) {
+            chunk = u64(opIdx % kRadix);
+            opIdx /= kRadix;
+        } else {
+            Int q, r;
+            divide_qr(opIdx, Int(kRadix), q, r);
+            chunk = r.template convert_to<u64>();
+            opIdx = std::move(q);
+            count_ops<Int>(1);
+        }
+        std::size_t n = std::min(ops.size() - i, std::size_t(kDigits));
+        kernels::base3_digits(chunk, ops.data() + i, n);
+        i += n;
+    }
+    return ops;
+}
+
+/* builds the expression string */
+template <class Int>
+std::string emit_expr(const std::string &sig, Int opIdx,
+                      const std::vector<int> &lbl) {
+    return ::emit_expr(sig, decode_ops<Int>(sig, opIdx), lbl);
+}
+
+/* Computes shape, opIdx, and labels for nth expression */
+template <class Int>
+void compute_expr_components(const Int &N, std::string &sig, Int &opIdx,
+                             std::vector<int> &labels) {
+    using T = Tables<Int>;
+    int n = 0;
+    {
+        CIRC_PHASE(SizeSearch);
+        int limit = size_limit();
+        int hi = std::min(built_sizes<Int>(), limit + 1) - 1;
+        for (hi = std::max(hi, 0); !(T::prefixN(hi) > N); ++hi)
+            if (hi >= limit)
+                throw std::runtime_error("Index is beyond the size limit");
+        while (n < hi) {
+            int m = (n + hi) / 2;
+            (T::prefixN(m) > N) ? hi = m : n = m + 1;
+            count_ops<Int>(1);
+        }
+    }
+    Int rem = N - (n ? T::prefixN(n - 1) : Int(0));
+
+    int sSel = 0, uSel = 0;
+    {
+        CIRC_PHASE(BlockScan);
+        /* blocks run s = 1…n+1, i.e. u = n…0 */
+        const auto &start = T::BlockStart(n);
+        int j = int(std::upper_bound(start.begin() + 1, start.end(), rem) -
+                    start.begin()) -
+                1;
+        count_ops<Int>(std::size_t(std::bit_width(start.size())) + 1);
+        rem -= start[j];
+        sSel = j + 1;
+        uSel = n - j;
+    }
+
+    const Int &span = T::ShapeSpan(sSel);
+    Int shapeIdx = rem / span;
+    Int tmp = rem % span;
+    opIdx = tmp / T::Bell(sSel);
+    Int rgsIdx = tmp % T::Bell(sSel);
+    count_ops<Int>(4);
+
+    {
+        CIRC_PHASE(UnrankShape);
+        unrank_shape_into<Int>(sSel, uSel, shapeIdx, sig);
+    }
+    labels = unrank_rgs<Int>(sSel, rgsIdx);
+}
+
+#define TIERED_INSTANTIATE(Int)                                                \
+    template const SizeLayer<Int> &layer<Int>(int);                            \
+    template int built_sizes<Int>();                                           \
+    template const std::vector<Int> &split_table<Int>(int, int);               \
+    template std::vector<int> unrank_rgs<Int>(int, Int);                       \
+    template std::string unrank_shape<Int>(int, int, Int);                     \
+    template void unrank_shape_into<Int>(int, int, Int, std::string &);        \
+    template std::vector<std::uint8_t> decode_ops<Int>(const std::string &,    \
+                                                       Int);                   \
+    template std::string emit_expr<Int>(const std::string &, Int,              \
+                                        const std::vector<int> &);             \
+    template void compute_expr_components<Int>(                                \
+        const Int &, std::string &, Int &, std::vector<int> &);
+
+TIERED_INSTANTIATE(u64)
+TIERED_INSTANTIATE(u128)
+TIERED_INSTANTIATE(u1024)
+TIERED_INSTANTIATE(bigint)
+
+#undef TIERED_INSTANTIATE
+
+} // namespace tiered
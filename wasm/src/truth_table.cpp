@@ -0,0 +1,97 @@
+#include "truth_table.h"
+#include "kernels.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+/* Words evaluated per pass; keeps the value stack in L1/L2 */
+constexpr std::size_t kBlockWords = 64;
+
+/* Bit patterns of the first six variables inside one 64-row word */
+constexpr std::uint64_t kVarMask[6] = {
+    0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL,
+};
+
+/* Writes variable v for words [w0, w0 + n) */
+void fill_var(std::uint64_t *dst, int v, std::size_t w0, std::size_t n) {
+    if (v < 6) {
+        std::fill_n(dst, n, kVarMask[v]);
+        return;
+    }
+    for (std::size_t i = 0; i < n; ++i)
+        dst[i] = (w0 + i) >> (v - 6) & 1 ? ~0ULL : 0;
+}
+
+} // namespace
+
+/* Evaluates all 2^vars rows at once, 64 rows per word operation.
+ *
+ * The preorder signature is scanned right to left so every node finds its
+ * children on top of a value stack: left child first, then right. */
+void truth_table(const std::string &sig, const std::vector<std::uint8_t> &ops,
+                 const std::vector<int> &labels, TruthTable &tt) {
+    tt.vars = 0;
+    for (int l : labels)
+        tt.vars = std::max(tt.vars, l + 1);
+    if (tt.vars > kMaxTruthTableVars)
+        throw std::runtime_error("Too many variables for a truth table: " +
+                                 std::to_string(tt.vars));
+
+    std::size_t nWords = tt.vars > 6 ? std::size_t(1) << (tt.vars - 6) : 1;
+    tt.words.resize(nWords);
+    thread_local std::vector<std::uint64_t> stack;
+    stack.resize(std::max(stack.size(), labels.size() * kBlockWords));
+
+    for (std::size_t w0 = 0; w0 < nWords; w0 += kBlockWords) {
+        std::size_t n = std::min(kBlockWords, nWords - w0);
+        std::size_t sp = 0, lp = labels.size(), op = ops.size();
+        for (std::size_t i = sig.size(); i-- > 0;) {
+            char t = sig[i];
+            if (t == 'L') {
+                fill_var(&stack[sp++ * kBlockWords], labels[--lp], w0, n);
+                continue;
+            }
+            std::uint64_t *a = &stack[(sp - 1) * kBlockWords];
+            if (t == 'U') {
+                kernels::not_words(a, n);
+                continue;
+            }
+            std::uint64_t *r = &stack[(sp - 2) * kBlockWords];
+            switch (ops[--op]) {
+            case 0:
+                kernels::and_words(r, a, n);
+                break;
+            case 1:
+                kernels::or_words(r, a, n);
+                break;
+            default:
+                kernels::xor_words(r, a, n);
+                break;
+            }
+            --sp;
+        }
+        std::copy_n(stack.begin(), n, tt.words.begin() + w0);
+    }
+
+    if (tt.vars < 6)
+        tt.words[0] &= (1ULL << (1u << tt.vars)) - 1;
+}
+
+TruthTable truth_table(const std::string &sig,
+                       const std::vector<std::uint8_t> &ops,
+                       const std::vector<int> &labels) {
+    TruthTable tt;
+    truth_table(sig, ops, labels, tt);
+    return tt;
+}
+
+/* Returns the full truth table for index N */
+TruthTable truth_table(bigint N) {
+    std::string sig;
+    std::vector<std::uint8_t> ops;
+    std::vector<int> labels;
+    compute_expr_components(N, sig, ops, labels);
+    return truth_table(sig, ops, labels);
+}
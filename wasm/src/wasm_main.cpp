@@ -1,24 +1,317 @@
+#include "compiled_expr.h"
 #include "compute.h"
 #include "compute_data.h"
+#include "cursor.h"
+#include "decimal.h"
+#include "expr_cache.h"
+#include "flat_expr.h"
+#include "instrument.h"
+#include "kernels.h"
+#ifdef CIRCFINITY_WASM_THREADS
+#include "parallel.h"
+#endif
+#include "sampler.h"
+#include "search.h"
+#include "truth_table.h"
 #include <emscripten/bind.h>
+#include <emscripten/val.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
 #include <string>
 
-std::string get_expr_full_wrapper(std::string n_str) {
-    bigint n(n_str);
-    return get_expr_full(n);
+/* Index arguments are a decimal string or a Uint8Array of little-endian
+ * magnitude bytes (see bigIntToBytes in the frontend) */
+bigint index_arg(const emscripten::val &v) {
+    if (v.isString())
+        return from_decimal(v.as<std::string>());
+    auto bytes = emscripten::vecFromJSArray<std::uint8_t>(v);
+    return from_le_bytes(bytes.data(), bytes.size());
 }
 
-std::string get_expr_count_wrapper() { return to_string(prefixN[MAX_N]); }
+emscripten::val index_bytes(const bigint &x) {
+    auto bytes = to_le_bytes(x);
+    return emscripten::val(
+               emscripten::typed_memory_view(bytes.size(), bytes.data()))
+        .call<emscripten::val>("slice");
+}
+
+/* Single-index lookups go through one LRU cache that also prefetches the
+ * neighbours, so stepping to N±1 is a hit */
+ExprCache &expr_cache() {
+    static ExprCache cache;
+    return cache;
+}
+
+/* Cached decode of n flattened into a reused FlatExpr */
+FlatExpr &cached_flat(emscripten::val n) {
+    static FlatExpr flat;
+    const ExprRecord &r = expr_cache().get(index_arg(n));
+    flatten_expr(r.sig, r.ops, r.labels, flat);
+    return flat;
+}
+
+std::string get_expr_full_wrapper(emscripten::val n) {
+    FlatExpr &flat = cached_flat(n);
+    std::string out = "{\"expr\":\"";
+    emit_flat(flat, out);
+    out += "\",\"tree\":";
+    serialise_flat(flat, out);
+    out += '}';
+    return out;
+}
+
+/* maxBytes is a Number, so budgets past 2^32 can be passed from JS; they
+ * are clamped to the largest size_t (4 GiB - 1 on wasm32). Negative and
+ * NaN budgets are rejected. */
+void expr_cache_configure(unsigned capacity, double maxBytes,
+                          unsigned prefetch) {
+    if (!(maxBytes >= 0))
+        throw std::runtime_error("maxBytes must be a non-negative number");
+    constexpr std::size_t top = std::numeric_limits<std::size_t>::max();
+    std::size_t bytes =
+        maxBytes >= double(top) ? top : std::size_t(maxBytes);
+    expr_cache().configure({capacity, bytes, prefetch});
+}
+
+/* {"entries","bytes","capacity","maxBytes","prefetch","hits","misses",
+ *  "prefetched","evictions"} */
+std::string expr_cache_stats() {
+    const ExprCache &c = expr_cache();
+    const ExprCacheOptions &o = c.options();
+    const ExprCacheStats &s = c.stats();
+    std::string out = "{";
+    auto field = [&](const char *name, std::uint64_t v) {
+        if (out.size() > 1)
+            out += ',';
+        out += '"';
+        out += name;
+        out += "\":";
+        out += std::to_string(v);
+    };
+    field("entries", c.size());
+    field("bytes", c.bytes());
+    field("capacity", o.capacity);
+    field("maxBytes", o.maxBytes);
+    field("prefetch", o.prefetch);
+    field("hits", s.hits);
+    field("misses", s.misses);
+    field("prefetched", s.prefetched);
+    field("evictions", s.evictions);
+    return out + '}';
+}
+
+void expr_cache_clear() { expr_cache().clear(); }
+
+/* Number of expressions up to the current size limit */
+std::string get_expr_count_wrapper() {
+    return to_string(prefixN[size_limit()]);
+}
+
+emscripten::val get_expr_count_bytes() {
+    return index_bytes(prefixN[size_limit()]);
+}
+
+/* prefixN[kStableSize]: indices below it kept their expression when the
+ * tables became complete; links to later ones now show another one */
+std::string stable_count() { return to_string(prefixN[kStableSize]); }
+
+/* Workers range queries are split across: the pthread pool started with
+ * wasm_main_mt (CIRCFINITY_WASM_THREADS is its size), 1 otherwise */
+unsigned thread_count() {
+#ifdef CIRCFINITY_WASM_THREADS
+    return CIRCFINITY_WASM_THREADS;
+#else
+    return 1;
+#endif
+}
+
+/* Kernel set compiled in: "simd128" for wasm_main_simd / wasm_main_mt
+ * (when built with SIMD), "scalar" otherwise */
+std::string simd_backend() { return kernels::backend(); }
+
+#ifdef CIRCFINITY_WASM_THREADS
+/* below this many indices the pool costs more than it saves */
+constexpr unsigned kParallelRange = 4096;
+
+EnumerateOptions pool_options() {
+    EnumerateOptions opts;
+    opts.threads = thread_count();
+    return opts;
+}
+#endif
+
+/* count expressions from start, '\n'-separated, in one call */
+std::string get_expr_range_wrapper(emscripten::val start, unsigned count) {
+#ifdef CIRCFINITY_WASM_THREADS
+    if (count >= kParallelRange)
+        return get_expr_range_parallel(index_arg(start), count,
+                                       pool_options());
+#endif
+    return get_expr_range(index_arg(start), count);
+}
 
-std::string evaluate_expr_full_json_wrapper(std::string n_str,
+/* JSON array of get_expr_full objects for the same range */
+std::string get_expr_range_full_wrapper(emscripten::val start,
+                                        unsigned count) {
+#ifdef CIRCFINITY_WASM_THREADS
+    if (count >= kParallelRange)
+        return get_expr_range_full_parallel(index_arg(start), count,
+                                            pool_options());
+#endif
+    return get_expr_range_full(index_arg(start), count);
+}
+
+/* { expr, vars, ops, labels }: ops (Uint8Array, NodeOp codes 0..4 =
+ * VAR/NOT/AND/OR/XOR) and labels (Uint16Array) are views straight into
+ * WASM memory, one entry per preorder node. They are overwritten by the
+ * next call and detached if memory grows, so read them right away. */
+emscripten::val get_expr_tree_wrapper(emscripten::val n) {
+    static PackedTree packed;
+    FlatExpr &flat = cached_flat(n);
+    pack_flat(flat, packed);
+
+    std::string expr;
+    emit_flat(flat, expr);
+    emscripten::val out = emscripten::val::object();
+    out.set("expr", expr);
+    out.set("vars", flat.vars);
+    out.set("ops", emscripten::val(emscripten::typed_memory_view(
+                       packed.ops.size(), packed.ops.data())));
+    out.set("labels", emscripten::val(emscripten::typed_memory_view(
+                          packed.labels.size(), packed.labels.data())));
+    return out;
+}
+
+/* Decodes through the hot-index cache, so compiling the index whose tree
+ * was just fetched costs no unranking; the returned handle must be
+ * released with .delete() */
+CompiledExpr compile_wrapper(emscripten::val n) {
+    return CompiledExpr(expr_cache().get(index_arg(n)));
+}
+
+/* A mask is a Number (up to 53 variables) or a Uint32Array with variable i
+ * in bit i % 32 of element i / 32 */
+std::vector<std::uint32_t> mask_words(const CompiledExpr &c,
+                                      const emscripten::val &mask) {
+    std::vector<std::uint32_t> words(std::max<std::size_t>(2, c.mask_words()));
+    if (mask.isNumber()) {
+        double d = mask.as<double>();
+        words[0] = std::uint32_t(std::fmod(d, 4294967296.0));
+        words[1] = std::uint32_t(d / 4294967296.0);
+    } else {
+        auto in = emscripten::vecFromJSArray<std::uint32_t>(mask);
+        std::copy_n(in.begin(), std::min(in.size(), words.size()),
+                    words.begin());
+    }
+    return words;
+}
+
+bool compiled_eval(CompiledExpr &c, emscripten::val mask) {
+    return c.eval(mask_words(c, mask).data());
+}
+
+/* Uint32Array with node i (preorder) in bit i % 32 of element i / 32 */
+emscripten::val compiled_eval_nodes(CompiledExpr &c, emscripten::val mask) {
+    const auto &bits = c.eval_nodes(mask_words(c, mask).data());
+    return emscripten::val(
+               emscripten::typed_memory_view(bits.size(), bits.data()))
+        .call<emscripten::val>("slice");
+}
+
+/* Uint32Array of preorder node ids whose value changed, children first */
+emscripten::val compiled_flip(CompiledExpr &c, int v) {
+    const auto &changed = c.flip(v);
+    return emscripten::val(
+               emscripten::typed_memory_view(changed.size(), changed.data()))
+        .call<emscripten::val>("slice");
+}
+
+/* count uniform draws, '\n'-separated; n < 0 draws from every size,
+ * s > 0 fixes the leaf count within size n */
+std::string sample_exprs(double seed, unsigned count, int n, int s) {
+    ExprSampler smp{std::uint64_t(seed)};
+    ExprRecord r;
+    FlatExpr flat;
+    std::string out;
+    for (unsigned i = 0; i < count; ++i) {
+        smp.sample({n, s}, r);
+        flatten_expr(r.sig, r.ops, r.labels, flat);
+        if (i)
+            out += '\n';
+        emit_flat(flat, out);
+    }
+    return out;
+}
+
+/* Decimal smallest index computing the row mask over vars variables, or
+ * "" when nothing up to maxSize does */
+std::string find_min_index_wrapper(int vars, unsigned mask, int maxSize) {
+    auto found = find_min_index(vars, mask, SearchOptions{maxSize});
+    return found ? to_string(*found) : std::string();
+}
+
+std::string evaluate_expr_full_json_wrapper(emscripten::val n,
                                             const std::string &jsonInputs) {
-    bigint N(n_str);
-    return evaluate_expr_full_json(N, jsonInputs);
+    return evaluate_expr_full_json(index_arg(n), jsonInputs);
+}
+
+std::string rank_expr_wrapper(const std::string &expr) {
+    return to_string(rank_expr(expr));
+}
+
+emscripten::val rank_expr_bytes(const std::string &expr) {
+    return index_bytes(rank_expr(expr));
+}
+
+/* { vars, words } where words is a Uint32Array holding the packed 64-bit
+ * rows as little-endian low/high halves */
+emscripten::val truth_table_wrapper(emscripten::val n) {
+    auto tt = truth_table(index_arg(n));
+    auto view = emscripten::typed_memory_view(
+        tt.words.size() * 2,
+        reinterpret_cast<const std::uint32_t *>(tt.words.data()));
+    emscripten::val out = emscripten::val::object();
+    out.set("vars", tt.vars);
+    out.set("words", emscripten::val(view).call<emscripten::val>("slice"));
+    return out;
 }
 
 EMSCRIPTEN_BINDINGS(my_module) {
     emscripten::function("get_expr_full", &get_expr_full_wrapper);
+    emscripten::function("get_expr_tree", &get_expr_tree_wrapper);
+    emscripten::function("get_expr_range", &get_expr_range_wrapper);
+    emscripten::function("get_expr_range_full", &get_expr_range_full_wrapper);
     emscripten::function("get_expr_count", &get_expr_count_wrapper);
+    emscripten::function("expr_cache_configure", &expr_cache_configure);
+    emscripten::function("expr_cache_stats", &expr_cache_stats);
+    emscripten::function("expr_cache_clear", &expr_cache_clear);
+    emscripten::function("get_expr_count_bytes", &get_expr_count_bytes);
+    emscripten::function("stable_count", &stable_count);
+    emscripten::function("sample_exprs", &sample_exprs);
+    emscripten::function("find_min_index", &find_min_index_wrapper);
+    emscripten::function("thread_count", &thread_count);
+    emscripten::function("simd_backend", &simd_backend);
+    emscripten::function("size_limit", &size_limit);
+    emscripten::function("set_size_limit", &set_size_limit);
+    emscripten::class_<CompiledExpr>("CompiledExpr")
+        .function("vars", &CompiledExpr::vars)
+        .function("nodes", &CompiledExpr::nodes)
+        .function("eval", &compiled_eval)
+        .function("evalNodes", &compiled_eval_nodes)
+        .function("flip", &compiled_flip)
+        .function("value", &CompiledExpr::value);
+    emscripten::function("compile", &compile_wrapper);
     emscripten::function("evaluate_expr_full_json",
                          &evaluate_expr_full_json_wrapper);
+    emscripten::function("rank_expr", &rank_expr_wrapper);
+    emscripten::function("rank_expr_bytes", &rank_expr_bytes);
+    emscripten::function("truth_table", &truth_table_wrapper);
+    /* instrumentation (reports "enabled":false unless built with
+     * CIRCFINITY_INSTRUMENT=ON) */
+    emscripten::function("instrument_stats", &instrument::stats_json);
+    emscripten::function("instrument_trace", &instrument::trace_json);
+    emscripten::function("instrument_reset", &instrument::reset);
+    emscripten::function("instrument_set_tracing", &instrument::set_tracing);
 }
@@ -0,0 +1,79 @@
+// node --test tests/node/modules.test.mjs, with WASM_DIR holding the
+// emscripten build. Every variant that was built (wasm_main_simd,
+// wasm_main_mt) must answer exactly like the scalar wasm_main.
+import { test } from "node:test";
+import assert from "node:assert/strict";
+import { createRequire } from "node:module";
+import { existsSync } from "node:fs";
+import path from "node:path";
+
+const require = createRequire(import.meta.url);
+const dir = process.env.WASM_DIR ?? process.cwd();
+const load = (name) => require(path.join(dir, `${name}.js`))();
+
+const base = await load("wasm_main");
+const variants = {};
+for (const name of ["wasm_main_simd", "wasm_main_mt"])
+  if (existsSync(path.join(dir, `${name}.js`))) variants[name] = await load(name);
+
+test("reported capabilities", () => {
+  assert.equal(base.thread_count(), 1);
+  assert.equal(base.simd_backend(), "scalar");
+  if (variants.wasm_main_simd) {
+    assert.equal(variants.wasm_main_simd.thread_count(), 1);
+    assert.equal(variants.wasm_main_simd.simd_backend(), "simd128");
+  }
+  if (variants.wasm_main_mt) assert.ok(variants.wasm_main_mt.thread_count() > 1);
+});
+
+test("stable range bound", () => {
+  // prefixN[99]: indices below it kept their pre-growth expressions
+  assert.match(base.stable_count(), /^24798444693452136850\d{194}$/);
+  assert.ok(BigInt(base.get_expr_count()) > BigInt(base.stable_count()));
+});
+
+test("cache budgets are clamped to size_t and must be numbers >= 0", () => {
+  try {
+    base.expr_cache_configure(256, 2 ** 40, 4);
+    assert.equal(JSON.parse(base.expr_cache_stats()).maxBytes, 2 ** 32 - 1);
+    assert.throws(() => base.expr_cache_configure(256, -1, 4));
+    assert.throws(() => base.expr_cache_configure(256, NaN, 4));
+  } finally {
+    base.expr_cache_configure(256, 4 << 20, 4);
+  }
+});
+
+for (const [name, mod] of Object.entries(variants)) {
+  test(`${name}: range queries match wasm_main`, () => {
+    for (const start of ["0", "123456", "98765432109876543210"]) {
+      assert.equal(mod.get_expr_range(start, 20000), base.get_expr_range(start, 20000));
+      assert.equal(
+        mod.get_expr_range_full(start, 5000),
+        base.get_expr_range_full(start, 5000),
+      );
+    }
+  });
+
+  test(`${name}: unranking and truth tables match wasm_main`, () => {
+    for (const n of ["0", "42", "31337", "12345678901234567890", "9".repeat(60)]) {
+      assert.equal(mod.get_expr_full(n), base.get_expr_full(n));
+      const a = mod.truth_table(n), b = base.truth_table(n);
+      assert.equal(a.vars, b.vars);
+      assert.deepEqual([...a.words], [...b.words]);
+    }
+  });
+
+  test(`${name}: compiled evaluation matches wasm_main`, () => {
+    const n = "98765432109876543210";
+    const a = mod.compile(n), b = base.compile(n);
+    try {
+      for (const mask of [0, 1, 0x5a5a5, 2 ** 40 - 1]) {
+        assert.equal(a.eval(mask), b.eval(mask));
+        assert.deepEqual([...a.evalNodes(mask)], [...b.evalNodes(mask)]);
+      }
+    } finally {
+      a.delete();
+      b.delete();
+    }
+  });
+}
@@ -0,0 +1,79 @@
+#include "classify.h"
+#include "compute_data.h"
+#include <catch2/catch_all.hpp>
+#include <map>
+
+namespace {
+
+/* Serial reference: one truth_table(N) per index */
+std::map<std::pair<int, std::vector<std::uint64_t>>, FunctionStats>
+reference(const bigint &start, const bigint &end) {
+    std::map<std::pair<int, std::vector<std::uint64_t>>, FunctionStats> ref;
+    for (bigint N = start; N < end; ++N) {
+        auto tt = truth_table(N);
+        auto &f = ref[{tt.vars, tt.words}];
+        if (f.count++ == 0) {
+            f.table = tt;
+            f.first = N;
+            int n = 0;
+            while (prefixN[n] <= N)
+                ++n;
+            f.minSize = n;
+        }
+    }
+    return ref;
+}
+
+} // namespace
+
+TEST_CASE("classify – matches a serial truth-table pass") {
+    ClassifyOptions opts;
+    opts.enumerate.threads = 4;
+    opts.localEntries = 8; // force many merges
+    for (auto [start, end] : {std::pair<bigint, bigint>{0, prefixN[3]},
+                              {prefixN[2] + 5, prefixN[4] - 3}}) {
+        auto hist = classify_range(start, end, opts);
+        auto ref = reference(start, end);
+        REQUIRE(hist.expressions == std::uint64_t(end - start));
+        REQUIRE(hist.wide == 0);
+        REQUIRE(hist.untracked == 0);
+        REQUIRE(hist.functions.size() == ref.size());
+        for (std::size_t i = 0; i < hist.functions.size(); ++i) {
+            const auto &f = hist.functions[i];
+            const auto &r = ref.at({f.table.vars, f.table.words});
+            REQUIRE(f.count == r.count);
+            REQUIRE(f.first == r.first);
+            REQUIRE(f.minSize == r.minSize);
+            if (i)
+                REQUIRE(hist.functions[i - 1].first < f.first);
+        }
+    }
+}
+
+TEST_CASE("classify – size and variable bounds") {
+    ClassifyOptions opts;
+    opts.enumerate.threads = 3;
+    auto all = classify_size(3, opts);
+    REQUIRE(all.expressions == std::uint64_t(Wn[3]));
+    for (const auto &f : all.functions)
+        REQUIRE(f.minSize == 3);
+
+    opts.maxVars = 2;
+    auto narrow = classify_size(3, opts);
+    REQUIRE(narrow.wide > 0);
+    for (const auto &f : narrow.functions)
+        REQUIRE(f.table.vars <= 2);
+
+    opts.maxVars = 16;
+    opts.maxFunctions = 5;
+    opts.localEntries = 2;
+    auto capped = classify_size(3, opts);
+    REQUIRE(capped.functions.size() == 5);
+    std::uint64_t counted = capped.untracked;
+    for (const auto &f : capped.functions)
+        counted += f.count;
+    REQUIRE(counted == capped.expressions);
+
+    opts.maxVars = kMaxTruthTableVars + 1;
+    REQUIRE_THROWS_AS(classify_size(1, opts), std::runtime_error);
+}
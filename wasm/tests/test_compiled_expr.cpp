@@ -0,0 +1,98 @@
+#include "compiled_expr.h"
+#include "compute.h"
+#include "compute_data.h"
+#include "expr_cache.h"
+#include "truth_table.h"
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <vector>
+
+TEST_CASE("CompiledExpr – eval agrees with truth_table") {
+    for (bigint N = 0; N < 3000; N += 7) {
+        CompiledExpr c(N);
+        auto tt = truth_table(N);
+        REQUIRE(c.vars() == tt.vars);
+        REQUIRE(c.mask_words() == 1);
+        for (std::uint32_t r = 0; r < (1u << c.vars()); ++r)
+            REQUIRE(c.eval(&r) == tt.row(r));
+    }
+}
+
+TEST_CASE("CompiledExpr – eval_nodes matches evaluate_expr_full_json") {
+    CompiledExpr c(rank_expr("AND(A,NOT(B))"));
+    REQUIRE(c.nodes() == 4);
+    std::uint32_t mask = 0b01; // A = 1, B = 0
+    REQUIRE(c.eval_nodes(&mask) == std::vector<std::uint32_t>{0b0111});
+    mask = 0b11;
+    REQUIRE(c.eval_nodes(&mask) == std::vector<std::uint32_t>{0b1010});
+    REQUIRE_FALSE(c.eval(&mask));
+}
+
+TEST_CASE("CompiledExpr – from a cached record") {
+    ExprCache cache;
+    for (bigint N : std::vector<bigint>{0, 4321, prefixN[12] + 99}) {
+        CompiledExpr a(N), b(cache.get(N));
+        REQUIRE(a.nodes() == b.nodes());
+        REQUIRE(a.vars() == b.vars());
+        std::vector<std::uint32_t> mask(a.mask_words() + 1, 0x5A5A5A5Au);
+        REQUIRE(a.eval_nodes(mask.data()) == b.eval_nodes(mask.data()));
+    }
+}
+
+TEST_CASE("CompiledExpr – masks wider than one word") {
+    /* last index of size 40: 41 leaves labelled A … AO */
+    bigint N = prefixN[40] - 1;
+    CompiledExpr c(N);
+    REQUIRE(c.vars() == 41);
+    REQUIRE(c.mask_words() == 2);
+    REQUIRE(c.nodes() > 32);
+
+    std::vector<std::uint32_t> mask{0xFFFFFFFFu, 0x1FFu};
+    auto bits = c.eval_nodes(mask.data());
+    REQUIRE(bits.size() == (c.nodes() + 31) / 32);
+    REQUIRE((bits[0] & 1) == c.eval(mask.data()));
+}
+
+TEST_CASE("CompiledExpr – flip matches full re-evaluation") {
+    std::vector<std::uint8_t> values;
+    for (bigint N : std::vector<bigint>{0, 5, 777, prefixN[9] + 12345,
+                                        prefixN[30] - 1}) {
+        CompiledExpr c(N);
+        std::vector<std::uint8_t> in(c.vars(), 0);
+        std::uint32_t step = 0x9E3779B9u;
+        for (int k = 0; k < 200; ++k) {
+            step = step * 1664525u + 1013904223u;
+            int v = int(step >> 8) % c.vars();
+            auto before = std::vector<bool>(c.nodes());
+            for (std::size_t i = 0; i < c.nodes(); ++i)
+                before[i] = c.value(i);
+
+            const auto &changed = c.flip(v);
+            in[v] ^= 1;
+            evaluate_flat(c.flat(), in.data(), values);
+
+            std::vector<bool> seen(c.nodes());
+            for (auto i : changed)
+                seen[i] = true;
+            for (std::size_t i = 0; i < c.nodes(); ++i) {
+                REQUIRE(c.value(i) == bool(values[i]));
+                REQUIRE(seen[i] == (before[i] != bool(values[i])));
+            }
+        }
+    }
+}
+
+TEST_CASE("CompiledExpr – flip stops at unchanged nodes") {
+    CompiledExpr c(rank_expr("NOT(AND(A,NOT(B)))"));
+    std::uint32_t mask = 0b10; // A = 0, B = 1
+    c.eval_nodes(&mask);
+    /* A feeds an AND whose other input is 0: only the leaf changes */
+    REQUIRE(c.flip(0) == std::vector<std::uint32_t>{2});
+    REQUIRE(c.value(0));
+    /* B now reaches the root: leaf, NOT, AND, NOT in that order */
+    REQUIRE(c.flip(1) == std::vector<std::uint32_t>{4, 3, 1, 0});
+    REQUIRE_FALSE(c.value(0));
+    REQUIRE(c.input(0));
+    REQUIRE_FALSE(c.input(1));
+    REQUIRE_THROWS(c.flip(2));
+}
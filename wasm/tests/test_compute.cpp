@@ -1,9 +1,15 @@
 #include "compute.h"
 #include "compute_data.h"
+#include "reference_tables.h"
 #include <catch2/catch_all.hpp>
 #include <unordered_set>
 #include <vector>
 
+using reference::kMaxLabels;
+using reference::MAX_N;
+using reference::MAX_S;
+using reference::MAX_U;
+
 // helpers ---------------------------------------------------------------
 static bigint ipow(bigint b, int e) {
     bigint r = 1;
@@ -180,10 +186,8 @@ TEST_CASE("DP_RGS – recurrence", "[DP_RGS]") {
 TEST_CASE("Wn – closed-form cross-check") {
     for (int n = 0; n <= MAX_N; ++n) {
         bigint w = 0;
-        for (int u = 0; u <= n && u <= MAX_U; ++u) {
+        for (int u = 0; u <= n; ++u) {
             int s = n - u + 1, b = n - u;
-            if (s < 1 || s > MAX_S)
-                continue;
             w += C[s][u] * Pow3[b] * Bell[s];
         }
         REQUIRE(w == Wn[n]);
@@ -414,3 +418,69 @@ TEST_CASE("nth_expression – size matches rank-partition") {
             REQUIRE(got == n);
         }
 }
+
+// ─────────────────────────────────────────────────────────────
+// rank_rgs / rank_shape
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("rank_rgs – inverse of unrank_rgs for len≤6") {
+    for (int len = 1; len <= 6; ++len)
+        for (bigint k = 0; k < Bell[len]; ++k)
+            REQUIRE(rank_rgs(unrank_rgs(len, k)) == k);
+    REQUIRE_THROWS(rank_rgs({1}));
+    REQUIRE_THROWS(rank_rgs({0, 2}));
+}
+
+TEST_CASE("rank_shape – inverse of unrank_shape for s≤5,u≤3") {
+    for (int s = 1; s <= 5; ++s)
+        for (int u = 0; u <= 3; ++u)
+            for (bigint k = 0; k < C[s][u]; ++k)
+                REQUIRE(rank_shape(unrank_shape(s, u, k)) == k);
+    REQUIRE_THROWS(rank_shape("BULL")); // past the C[2][1] cut-off
+    REQUIRE_THROWS(rank_shape("BL"));
+    REQUIRE_THROWS(rank_shape("LL"));
+}
+
+// ─────────────────────────────────────────────────────────────
+// rank_expr / rank_tree
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("rank_expr – round-trips get_expr for first 5000") {
+    for (bigint i = 0; i < 5000; ++i)
+        REQUIRE(rank_expr(get_expr(i)) == i);
+}
+
+TEST_CASE("rank_expr – round-trips large indices") {
+    const bigint last = prefixN[MAX_N] - 1;
+    for (bigint i : std::vector<bigint>{prefixN[20] + 12345, bigint(1) << 300,
+                                        last / 3, last}) {
+        INFO("i=" << i);
+        REQUIRE(rank_expr(get_expr(i)) == i);
+    }
+}
+
+TEST_CASE("rank_expr – whitespace & rejects") {
+    REQUIRE(rank_expr(" XOR( A , NOT( B ) ) ") == rank_expr("XOR(A,NOT(B))"));
+    REQUIRE_THROWS(rank_expr("XOR(NOT(A),B)")); // shape past the cut-off
+    REQUIRE_THROWS(rank_expr("B"));
+    REQUIRE_THROWS(rank_expr("AND(A,B"));
+    REQUIRE_THROWS(rank_expr("NAND(A,B)"));
+    REQUIRE_THROWS(rank_expr("AND(A,B)C"));
+}
+
+TEST_CASE("rank_tree – round-trips emit_expr_both") {
+    for (bigint i : std::vector<bigint>{0, 77, prefixN[10] + 999}) {
+        std::string sig;
+        bigint opIdx;
+        std::vector<int> labels;
+        compute_expr_components(i, sig, opIdx, labels);
+        auto [expr, tree] = emit_expr_both(sig, opIdx, labels);
+        REQUIRE(rank_tree(tree.get()) == i);
+        REQUIRE(rank_expr(expr) == i);
+    }
+    REQUIRE_THROWS(rank_tree(nullptr));
+    for (std::string bad : {"", "[", "a", "A1"}) {
+        INFO("label=" << bad);
+        ExprTree leaf{"VAR", bad, nullptr, nullptr};
+        REQUIRE_THROWS_WITH(rank_tree(&leaf),
+                            Catch::Matchers::StartsWith("Bad label"));
+    }
+}
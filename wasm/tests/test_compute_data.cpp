@@ -0,0 +1,153 @@
+#include "compute.h"
+#include "compute_data.h"
+#include "reference_tables.h"
+#include "tiered.h"
+#include <catch2/catch_all.hpp>
+#include <memory>
+#include <string>
+
+using namespace tiered;
+using reference::MAX_S;
+using reference::MAX_U;
+
+// ─────────────────────────────────────────────────────────────
+// generated / grown tables vs the reference builders
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("tables – match the reference builders") {
+    for (int k = 0; k <= MAX_S; ++k) {
+        REQUIRE(Pow3[k] == reference::Pow3[k]);
+        REQUIRE(Bell[k] == reference::Bell[k]);
+    }
+    for (int s = 0; s <= MAX_S; ++s)
+        for (int u = 0; u <= MAX_U; ++u)
+            REQUIRE(C[s][u] == reference::C[s][u]);
+    /* the old square dropped DP_RGS[len][MAX_S + 1], which skews entries
+     * past the len + max <= MAX_S + 1 triangle that unranking reads */
+    for (int l = 0; l <= MAX_S; ++l)
+        for (int m = 0; l + m <= MAX_S + 1; ++m)
+            REQUIRE(DP_RGS[l][m] == reference::DP_RGS[l][m]);
+    for (int n = 0; n < MAX_S; ++n) {
+        REQUIRE(Wn[n] == reference::Wn[n]);
+        REQUIRE(prefixN[n] == reference::prefixN[n]);
+    }
+}
+
+TEST_CASE("tables – limb spans of the generated layers") {
+    REQUIRE(table_limbs::size() >= 40);
+    REQUIRE(table_limbs::Pow3(0).len == 1);
+    REQUIRE(table_limbs::Pow3(0).limbs[0] == 1);
+    REQUIRE(table_limbs::Pow3(40).len == 1);
+    REQUIRE(table_limbs::Pow3(41).len == 2);
+    REQUIRE(table_limbs::C(3, 0).limbs[0] == 1);     // C[1][3]
+    REQUIRE(table_limbs::C(3, 3).limbs[0] == 5);     // C[4][0]
+    REQUIRE(table_limbs::DP_RGS(2, 0).limbs[0] == 1); // DP_RGS[0][3]
+}
+
+TEST_CASE("tables – narrow tiers saturate") {
+    for (int s = 0; s <= 60; ++s)
+        for (int u = 0; u <= 60; ++u) {
+            const bigint &c = C[s][u];
+            REQUIRE(Tables<u64>::C(s, u) == narrow<u64>(c));
+            REQUIRE(Tables<u128>::C(s, u) == narrow<u128>(c));
+            REQUIRE(widen(Tables<u1024>::C(s, u)) == c);
+        }
+    for (int n = 0; n <= 120; ++n) {
+        REQUIRE(Tables<u64>::prefixN(n) == narrow<u64>(prefixN[n]));
+        REQUIRE(Tables<u128>::prefixN(n) == narrow<u128>(prefixN[n]));
+        REQUIRE(Tables<u1024>::prefixN(n) == narrow<u1024>(prefixN[n]));
+    }
+}
+
+// ─────────────────────────────────────────────────────────────
+// size limit
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("size limit – indices past it are rejected") {
+    std::string deep = "A";
+    for (int i = 0; i < 31; ++i)
+        deep = "NOT(" + deep + ")";
+
+    set_size_limit(30);
+    REQUIRE_NOTHROW(get_expr(prefixN[30] - 1));
+    REQUIRE_THROWS(get_expr(prefixN[30]));
+    REQUIRE_THROWS(rank_expr(deep));
+    REQUIRE_THROWS(set_size_limit(kMaxSizeLimit + 1));
+    set_size_limit(kDefaultSizeLimit);
+    REQUIRE(rank_expr(deep) == prefixN[30]);
+}
+
+TEST_CASE("size limit – deep nesting is rejected without recursion") {
+    constexpr int kDepth = 200000;
+    std::string deep;
+    deep.reserve(kDepth * 5 + 1);
+    for (int i = 0; i < kDepth; ++i)
+        deep += "NOT(";
+    deep += 'A';
+    deep.append(kDepth, ')');
+    REQUIRE_THROWS_WITH(rank_expr(deep), "Shape exceeds the size limit");
+    REQUIRE_THROWS_WITH(rank_shape(std::string(kDepth, 'U') + 'L'),
+                        "Shape exceeds the size limit");
+
+    /* one node over the limit */
+    auto root = std::make_unique<ExprTree>(ExprTree{"VAR", "A", {}, {}});
+    for (int i = 0; i <= size_limit(); ++i)
+        root = std::make_unique<ExprTree>(
+            ExprTree{"NOT", "", std::move(root), nullptr});
+    REQUIRE_THROWS_WITH(rank_tree(root.get()), "Shape exceeds the size limit");
+}
+
+TEST_CASE("size limit – rank/unrank past the default limit") {
+    set_size_limit(kDefaultSizeLimit + 6);
+    for (int n : {kDefaultSizeLimit + 1, kDefaultSizeLimit + 6}) {
+        REQUIRE(prefixN[n] == prefixN[n - 1] + Wn[n]);
+        for (bigint N : std::vector<bigint>{prefixN[n - 1], prefixN[n - 1] + 12345,
+                                            prefixN[n] - 1}) {
+            std::string e = get_expr(N);
+            REQUIRE(rank_expr(e) == N);
+        }
+    }
+    REQUIRE(Labels[kDefaultSizeLimit + 6] == "GX");
+    set_size_limit(kDefaultSizeLimit);
+}
+
+TEST_CASE("size limit – indices below prefixN[99] keep their baseline order") {
+    /* The fixed 100x100 tables skipped blocks from size 100 on, so only
+     * these indices are stable across the change; the frontend flags the
+     * rest with the same boundary */
+    REQUIRE(kStableSize == 99);
+    REQUIRE(to_string(prefixN[kStableSize]) ==
+            "24798444693452136850667893499466353388900835194761414741811077780"
+            "76005603029309635471625307682930933353938421631384415470108190885"
+            "73902146356430908018941988015696501460093760963408128598421721408"
+            "9551841193325839883646778");
+    REQUIRE(get_expr(prefixN[60] / 3) ==
+            "XOR(A,OR(AND(AND(A,B),OR(XOR(A,C),AND(XOR(XOR(D,AND(OR(OR(XOR(E,"
+            "F),G),H),OR(AND(OR(I,J),C),AND(XOR(G,K),L)))),L),XOR(H,AND(AND("
+            "OR(E,M),AND(XOR(G,XOR(XOR(B,XOR(XOR(E,H),AND(J,AND(AND(XOR(A,L),"
+            "XOR(G,AND(E,I))),J)))),OR(AND(N,E),AND(OR(M,OR(D,AND(O,AND(P,I))"
+            ")),H)))),OR(XOR(H,C),F))),K))))),XOR(P,AND(XOR(XOR(XOR(XOR(K,J),"
+            "Q),OR(OR(AND(L,OR(D,O)),OR(B,P)),XOR(OR(XOR(O,F),OR(XOR(M,E),I))"
+            ",I))),AND(K,I)),L))))");
+
+    /* last index of size 99: XOR over 100 distinct leaves */
+    std::string chain = "A";
+    for (int i = 1; i < 100; ++i)
+        chain = "XOR(" + chain + "," + Labels[i] + ")";
+    REQUIRE(get_expr(prefixN[99] - 1) == chain);
+}
+
+TEST_CASE("derived layers – spans, block starts and RGS reuse counts") {
+    for (int n : {0, 1, 7, 99, 100, 150}) {
+        const auto &L = size_layer(n);
+        INFO("n=" << n);
+        REQUIRE(L.ShapeSpan == Pow3[n] * Bell[n + 1]);
+        REQUIRE(L.BlockStart.size() == std::size_t(n + 2));
+        bigint acc = 0;
+        for (int s = 1; s <= n + 1; ++s) {
+            REQUIRE(BlockStart[n][s] == acc);
+            acc += C[s][n - s + 1] * Pow3[s - 1] * Bell[s];
+        }
+        REQUIRE(L.BlockStart.back() == Wn[n]);
+        for (int l = 0; l <= n + 1; ++l)
+            REQUIRE(L.RGSReuse[l] == (n + 2 - l) * DP_RGS[l][n + 1 - l]);
+    }
+}
@@ -0,0 +1,160 @@
+#include "compute.h"
+#include "compute_data.h"
+#include "cursor.h"
+#include <catch2/catch_all.hpp>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────
+// ExprCursor::next
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("ExprCursor – next matches get_expr for first 20000") {
+    ExprCursor cur;
+    for (bigint i = 0; i < 20000; ++i) {
+        REQUIRE(cur.index() == i);
+        REQUIRE(cur.expr() == get_expr(i));
+        REQUIRE(cur.next());
+    }
+}
+
+TEST_CASE("ExprCursor – prev retraces next") {
+    ExprCursor cur(20000);
+    for (bigint i = 20000; i > 0; --i) {
+        REQUIRE(cur.prev());
+        REQUIRE(cur.index() == i - 1);
+        REQUIRE(cur.expr() == get_expr(i - 1));
+    }
+    REQUIRE_FALSE(cur.prev());
+    REQUIRE(cur.index() == 0);
+
+    /* back across size boundaries, then forward again from the state prev
+     * left behind */
+    for (int n : {2, 5, 9, 40}) {
+        ExprCursor c(prefixN[n - 1] + 3);
+        for (int i = 0; i < 6; ++i) {
+            REQUIRE(c.prev());
+            REQUIRE(c.expr() == get_expr(c.index()));
+        }
+        REQUIRE(c.size() == n - 1);
+        for (int i = 0; i < 6; ++i) {
+            REQUIRE(c.next());
+            REQUIRE(c.expr() == get_expr(c.index()));
+        }
+        REQUIRE(c.index() == prefixN[n - 1] + 3);
+    }
+}
+
+TEST_CASE("ExprCursor – crosses block and size boundaries") {
+    for (int n : {2, 5, 9, 40}) {
+        ExprCursor cur(prefixN[n] - 3);
+        for (int i = 0; i < 6; ++i) {
+            INFO("n=" << n << " idx=" << cur.index());
+            REQUIRE(cur.expr() == get_expr(cur.index()));
+            REQUIRE(cur.next());
+        }
+        REQUIRE(cur.size() == n + 1);
+    }
+
+    /* every (s, u) block inside a size class */
+    int n = 6;
+    bigint base = prefixN[n - 1];
+    for (int u = n; u > 0; --u) {
+        int s = n - u + 1;
+        base += C[s][u] * Pow3[s - 1] * Bell[s];
+        ExprCursor cur(base - 1);
+        REQUIRE(cur.unary() == u);
+        REQUIRE(cur.next());
+        REQUIRE(cur.unary() == u - 1);
+        REQUIRE(cur.expr() == get_expr(base));
+    }
+}
+
+TEST_CASE("ExprCursor – shape successor order") {
+    for (int s = 1; s <= 5; ++s)
+        for (int u = 0; u <= 3; ++u) {
+            int n = s - 1 + u;
+            bigint first = n ? prefixN[n - 1] : bigint(0);
+            for (int uu = n; uu > u; --uu)
+                first += C[n - uu + 1][uu] * Pow3[n - uu] * Bell[n - uu + 1];
+            bigint span = Pow3[s - 1] * Bell[s];
+            for (bigint k = 0; k < C[s][u]; ++k) {
+                ExprCursor cur(first + k * span + span - 1);
+                REQUIRE(cur.signature() == unrank_shape(s, u, k));
+                if (k + 1 < C[s][u]) {
+                    REQUIRE(cur.next());
+                    REQUIRE(cur.signature() == unrank_shape(s, u, k + 1));
+                }
+            }
+        }
+}
+
+// ─────────────────────────────────────────────────────────────
+// ExprCursor::advance / end of range
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("ExprCursor – advance matches seek") {
+    ExprCursor cur(prefixN[30]);
+    for (bigint d : std::vector<bigint>{0, 1, 7, 15, 16, 1000, bigint(1) << 40,
+                                        prefixN[31], prefixN[60]}) {
+        bigint target = cur.index() + d;
+        REQUIRE(cur.advance(d));
+        REQUIRE(cur.index() == target);
+        REQUIRE(cur.expr() == get_expr(target));
+        REQUIRE(cur.next());
+        REQUIRE(cur.expr() == get_expr(target + 1));
+    }
+}
+
+TEST_CASE("ExprCursor – stops at the last index") {
+    const bigint last = prefixN[kDefaultSizeLimit] - 1;
+    ExprCursor cur(last - 1);
+    REQUIRE(cur.next());
+    REQUIRE(cur.expr() == get_expr(last));
+    REQUIRE_FALSE(cur.next());
+    REQUIRE_FALSE(cur.advance(5));
+    REQUIRE(cur.index() == last);
+    REQUIRE_THROWS(cur.seek(last + 1));
+    REQUIRE_THROWS(cur.advance(-1));
+}
+
+TEST_CASE("ExprCursor – end follows the size limit") {
+    set_size_limit(20);
+    ExprCursor cur(prefixN[20] - 2);
+    REQUIRE(cur.next());
+    REQUIRE_FALSE(cur.next());
+    REQUIRE_FALSE(cur.advance(1));
+    REQUIRE_THROWS(cur.seek(prefixN[20]));
+
+    set_size_limit(kDefaultSizeLimit);
+    REQUIRE(cur.next());
+    REQUIRE(cur.index() == prefixN[20]);
+    REQUIRE(cur.expr() == get_expr(prefixN[20]));
+}
+
+// ─────────────────────────────────────────────────────────────
+// get_expr_range / get_expr_range_full
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("get_expr_range – matches get_expr across sizes") {
+    for (bigint start : std::vector<bigint>{0, 17, prefixN[6] - 40,
+                                            prefixN[45] - 2}) {
+        std::string batch = get_expr_range(start, 100), want;
+        for (int i = 0; i < 100; ++i)
+            want += (i ? "\n" : "") + get_expr(start + i);
+        REQUIRE(batch == want);
+    }
+    REQUIRE(get_expr_range(5, 0).empty());
+}
+
+TEST_CASE("get_expr_range_full – JSON array of get_expr_full") {
+    bigint start = prefixN[4] - 2;
+    std::string want = "[";
+    for (int i = 0; i < 5; ++i)
+        want += (i ? "," : "") + get_expr_full(start + i);
+    REQUIRE(get_expr_range_full(start, 5) == want + "]");
+    REQUIRE(get_expr_range_full(0, 0) == "[]");
+}
+
+TEST_CASE("get_expr_range – stops at the size limit") {
+    set_size_limit(3);
+    REQUIRE(get_expr_range(prefixN[3] - 2, 10) ==
+            get_expr(prefixN[3] - 2) + "\n" + get_expr(prefixN[3] - 1));
+    set_size_limit(kDefaultSizeLimit);
+}
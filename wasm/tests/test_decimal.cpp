@@ -0,0 +1,63 @@
+#include "compute.h"
+#include "decimal.h"
+#include <catch2/catch_all.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+/* Deterministic numbers with no long runs of equal digits */
+bigint sample(int digits) {
+    bigint x = 0, step = bigint("982451653");
+    while (x < pow(bigint(10), digits - 1))
+        x = x * step + 12345;
+    return x % pow(bigint(10), digits);
+}
+
+} // namespace
+
+TEST_CASE("to_decimal / from_decimal – agree with cpp_int") {
+    std::vector<bigint> xs = {0, 1, 9, 10, bigint(~0ULL),
+                              bigint(~0ULL) + 1};
+    /* around the split sizes: 19·2^k digits and the base-case cut */
+    for (int d : {18, 19, 20, 37, 38, 39, 607, 608, 609, 1215, 1216, 1217,
+                  2432, 4864, 20000}) {
+        xs.push_back(pow(bigint(10), d));
+        xs.push_back(pow(bigint(10), d) - 1);
+        xs.push_back(sample(d));
+    }
+    /* a large power of ten times a small number: long zero runs */
+    xs.push_back(pow(bigint(10), 3000) * 7 + 3);
+
+    for (const auto &x : xs) {
+        std::string s = x.str();
+        REQUIRE(to_decimal(x) == s);
+        REQUIRE(from_decimal(s) == x);
+        REQUIRE(to_decimal(-x) == (x == 0 ? "0" : "-" + s));
+        REQUIRE(from_decimal("-" + s) == -x);
+    }
+    bigint p2 = pow(bigint(2), 10000);
+    REQUIRE(to_string(p2) == p2.str());
+}
+
+TEST_CASE("from_decimal – leading zeros and invalid input") {
+    REQUIRE(from_decimal("000123") == 123);
+    REQUIRE(from_decimal(std::string(2000, '0') + "42") == 42);
+    REQUIRE(from_decimal("0") == 0);
+    for (const char *bad : {"", "-", "12a", " 1", "1.5", "+3"})
+        REQUIRE_THROWS_AS(from_decimal(bad), std::runtime_error);
+}
+
+TEST_CASE("to_le_bytes / from_le_bytes – round-trip") {
+    REQUIRE(to_le_bytes(0).empty());
+    REQUIRE(to_le_bytes(0x0102) == std::vector<std::uint8_t>{0x02, 0x01});
+    for (const auto &x :
+         std::vector<bigint>{255, 256, bigint(pow(bigint(3), 1000))}) {
+        auto b = to_le_bytes(x);
+        REQUIRE(b.back() != 0);
+        REQUIRE(from_le_bytes(b.data(), b.size()) == x);
+    }
+    REQUIRE(from_le_bytes(nullptr, 0) == 0);
+    REQUIRE_THROWS_AS(to_le_bytes(-1), std::runtime_error);
+}
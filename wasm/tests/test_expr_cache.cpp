@@ -0,0 +1,84 @@
+#include "compute.h"
+#include "compute_data.h"
+#include "expr_cache.h"
+#include <catch2/catch_all.hpp>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+bool matches(const ExprRecord &r, const bigint &N) {
+    ExprRecord want;
+    compute_expr_components(N, want.sig, want.ops, want.labels);
+    return r.sig == want.sig && r.ops == want.ops && r.labels == want.labels;
+}
+
+} // namespace
+
+TEST_CASE("ExprCache – entries decode like compute_expr_components") {
+    ExprCache cache;
+    std::vector<bigint> at = {0, 7, prefixN[5] + 11, prefixN[40] - 1,
+                              prefixN[40], prefixN[40] + 1};
+    for (const bigint &N : at)
+        REQUIRE(matches(cache.get(N), N));
+    REQUIRE_THROWS_AS(cache.get(prefixN[size_limit()]), std::runtime_error);
+}
+
+TEST_CASE("ExprCache – neighbours are prefetched") {
+    ExprCacheOptions opts;
+    opts.prefetch = 3;
+    ExprCache cache(opts);
+    bigint N = prefixN[6] - 2; // straddles a size boundary
+    cache.get(N);
+    REQUIRE(cache.stats().misses == 1);
+    REQUIRE(cache.stats().prefetched == 6);
+    REQUIRE(cache.size() == 7);
+    for (int d = -3; d <= 3; ++d) {
+        REQUIRE(cache.contains(N + d));
+        REQUIRE(matches(cache.get(N + d), N + d));
+    }
+    REQUIRE(cache.stats().misses == 1);
+    REQUIRE(cache.stats().hits == 7);
+
+    /* stepping forward keeps hitting */
+    for (int d = 4; d < 40; ++d)
+        REQUIRE(matches(cache.get(N + d), N + d));
+    REQUIRE(cache.stats().misses == 1);
+
+    /* no negative indices at the start */
+    ExprCache start(opts);
+    start.get(1);
+    REQUIRE(start.contains(0));
+    REQUIRE(start.size() == 5);
+}
+
+TEST_CASE("ExprCache – capacity and byte budget") {
+    ExprCacheOptions opts;
+    opts.capacity = 5;
+    opts.prefetch = 4;
+    ExprCache cache(opts);
+    cache.get(1000);
+    REQUIRE(cache.size() == 5);
+    /* nearest neighbours survive, alternating sides */
+    REQUIRE(cache.contains(1000));
+    REQUIRE(cache.contains(1001));
+    REQUIRE(cache.contains(999));
+    REQUIRE(cache.contains(1002));
+    REQUIRE(cache.contains(998));
+
+    /* least recently used goes first */
+    cache.get(5000);
+    REQUIRE(cache.contains(5000));
+    REQUIRE_FALSE(cache.contains(1000));
+
+    opts.prefetch = 0;
+    opts.maxBytes = 1;
+    cache.configure(opts);
+    REQUIRE(cache.size() == 1); // the latest entry is always kept
+    REQUIRE(matches(cache.get(prefixN[30]), prefixN[30]));
+    REQUIRE(cache.size() == 1);
+
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.bytes() == 0);
+}
@@ -0,0 +1,109 @@
+#include "compute.h"
+#include "compute_data.h"
+#include "flat_expr.h"
+#include "truth_table.h"
+#include <catch2/catch_all.hpp>
+#include <vector>
+
+// helpers ---------------------------------------------------------------
+static void flatten_index(const bigint &N, FlatExpr &flat) {
+    std::string sig;
+    bigint opIdx;
+    std::vector<int> labels;
+    compute_expr_components(N, sig, opIdx, labels);
+    flatten_expr(sig, decode_ops(sig, opIdx), labels, flat);
+}
+
+// ─────────────────────────────────────────────────────────────
+// flatten_expr
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("flatten_expr – preorder layout") {
+    FlatExpr flat;
+    flatten_expr("BBLULUL", {2, 1}, {0, 1, 0}, flat);
+    REQUIRE(flat.vars == 2);
+    REQUIRE(flat.nodes.size() == 7);
+    REQUIRE(flat.nodes[0].op == NodeOp::Xor);
+    REQUIRE(flat.nodes[0].right == 5);
+    REQUIRE(flat.nodes[1].op == NodeOp::Or);
+    REQUIRE(flat.nodes[1].right == 2);
+    REQUIRE(flat.nodes[2].op == NodeOp::Var);
+    REQUIRE(flat.nodes[2].label == 0);
+    REQUIRE(flat.nodes[3].op == NodeOp::Not);
+    REQUIRE(flat.nodes[4].label == 1);
+    REQUIRE(flat.nodes[5].op == NodeOp::Not);
+    REQUIRE(flat.nodes[6].label == 0);
+
+    std::string txt;
+    emit_flat(flat, txt);
+    REQUIRE(txt == "XOR(OR(A,NOT(B)),NOT(A))");
+}
+
+TEST_CASE("flatten_expr – reuse keeps capacity") {
+    FlatExpr flat;
+    flatten_index(prefixN[40] - 1, flat); /* largest shape of size 40 */
+    auto cap = flat.nodes.capacity();
+    auto *data = flat.nodes.data();
+    for (int n = 1; n < 40; n += 3) {
+        flatten_index(prefixN[n] - 1, flat);
+        REQUIRE(flat.nodes.data() == data);
+    }
+    REQUIRE(flat.nodes.capacity() == cap);
+}
+
+TEST_CASE("pack_flat – preorder columns") {
+    FlatExpr flat;
+    PackedTree packed;
+    flatten_expr("BBLULUL", {2, 1}, {0, 1, 0}, flat);
+    pack_flat(flat, packed);
+    REQUIRE(packed.ops == std::vector<std::uint8_t>{4, 3, 0, 1, 0, 1, 0});
+    REQUIRE(packed.labels == std::vector<std::uint16_t>{0, 0, 0, 0, 1, 0, 0});
+
+    flatten_index(0, flat);
+    pack_flat(flat, packed);
+    REQUIRE(packed.ops.size() == 1);
+}
+
+// ─────────────────────────────────────────────────────────────
+// emit_flat / serialise_flat / to_tree
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("emit_flat & serialise_flat – match tree adapter") {
+    FlatExpr flat;
+    for (bigint N : std::vector<bigint>{0, 1, 9, 500, prefixN[12] + 3,
+                                        prefixN[kDefaultSizeLimit] - 1}) {
+        flatten_index(N, flat);
+        auto tree = to_tree(flat);
+
+        std::string txt, json;
+        emit_flat(flat, txt);
+        serialise_flat(flat, json);
+        REQUIRE(txt == get_expr(N));
+        REQUIRE(json == serialise_tree(tree.get()));
+        REQUIRE(rank_tree(tree.get()) == N);
+    }
+}
+
+// ─────────────────────────────────────────────────────────────
+// evaluate_flat
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("evaluate_flat – agrees with truth_table") {
+    FlatExpr flat;
+    std::vector<std::uint8_t> values, in(8);
+    for (bigint N = 0; N < 2000; N += 3) {
+        flatten_index(N, flat);
+        auto tt = truth_table(N);
+        for (std::uint64_t r = 0; r < (1ULL << flat.vars); ++r) {
+            for (int v = 0; v < flat.vars; ++v)
+                in[v] = r >> v & 1;
+            REQUIRE(evaluate_flat(flat, in.data(), values) == tt.row(r));
+        }
+    }
+}
+
+TEST_CASE("evaluate_expr_full_json – per-node values in preorder") {
+    auto json =
+        evaluate_expr_full_json(rank_expr("AND(A,NOT(B))"),
+                                "{\"A\": true, \"B\": false}");
+    REQUIRE(json == "{\"n0\":true,\"n1\":true,\"n2\":true,\"n3\":false}");
+    REQUIRE_THROWS(evaluate_expr_full_json(rank_expr("AND(A,NOT(B))"),
+                                           "{\"A\": true}"));
+}
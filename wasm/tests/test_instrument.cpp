@@ -0,0 +1,72 @@
+#include "compute.h"
+#include "compute_data.h"
+#include "instrument.h"
+#include <catch2/catch_all.hpp>
+#include <string>
+
+using instrument::Counter;
+using instrument::Phase;
+
+namespace {
+
+const instrument::PhaseStats &phase(const instrument::Stats &s, Phase p) {
+    return s.phases[std::size_t(p)];
+}
+
+} // namespace
+
+TEST_CASE("instrument – phases and counters") {
+    instrument::reset();
+    get_expr_full(bigint("123456789012345678901234567890"));
+    auto s = instrument::snapshot();
+
+    if constexpr (instrument::kEnabled) {
+        for (Phase p : {Phase::SizeSearch, Phase::BlockScan,
+                        Phase::UnrankShape, Phase::UnrankRgs,
+                        Phase::DecodeOps, Phase::EmitText, Phase::EmitJson})
+            REQUIRE(phase(s, p).calls == 1);
+        REQUIRE(phase(s, Phase::BuildTree).calls == 0);
+        REQUIRE(s.counters[std::size_t(Counter::BigintOps)] == 0); // u128
+        REQUIRE(s.allocs > 0);
+
+        instrument::reset();
+        bigint big = prefixN[kDefaultSizeLimit] - 1;
+        REQUIRE(msb(big) >= 1024); // past the fixed-width tiers
+        get_expr(big);
+        s = instrument::snapshot();
+        REQUIRE(s.counters[std::size_t(Counter::BigintOps)] > 0);
+        REQUIRE(phase(s, Phase::SizeSearch).calls == 1);
+    } else {
+        for (const auto &ph : s.phases)
+            REQUIRE(ph.calls == 0);
+        REQUIRE(s.allocs == 0);
+    }
+}
+
+TEST_CASE("instrument – stats and trace JSON") {
+    instrument::reset();
+    instrument::set_tracing(true);
+    get_expr(42);
+    instrument::set_tracing(false);
+    get_expr(43);
+
+    auto stats = instrument::stats_json();
+    REQUIRE(stats.rfind(instrument::kEnabled ? "{\"enabled\":true"
+                                             : "{\"enabled\":false",
+                        0) == 0);
+    REQUIRE(stats.find("\"unrank_shape\":{\"calls\":") != std::string::npos);
+    REQUIRE(stats.find("\"bigint_ops\":") != std::string::npos);
+
+    auto trace = instrument::trace_json();
+    REQUIRE(trace.rfind("{\"traceEvents\":[", 0) == 0);
+    if constexpr (instrument::kEnabled) {
+        /* one traced call: each phase once */
+        std::size_t events = 0;
+        for (auto at = trace.find("\"ph\":\"X\""); at != std::string::npos;
+             at = trace.find("\"ph\":\"X\"", at + 1))
+            ++events;
+        REQUIRE(events == 6);
+        REQUIRE(trace.find("\"name\":\"decode_ops\"") != std::string::npos);
+    }
+    instrument::reset();
+}
@@ -0,0 +1,86 @@
+#include "kernels.h"
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+TEST_CASE("kernels – backend is named") {
+    std::string b = kernels::backend();
+    REQUIRE((b == "simd128" || b == "avx2" || b == "scalar"));
+}
+
+TEST_CASE("kernels – word ops match scalar loops at every length") {
+    std::mt19937_64 rng(7);
+    for (std::size_t n = 0; n <= 19; ++n) {
+        std::vector<std::uint64_t> a(n), r(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            a[i] = rng();
+            r[i] = rng();
+        }
+        auto want = r;
+
+        for (std::size_t i = 0; i < n; ++i)
+            want[i] &= a[i];
+        kernels::and_words(r.data(), a.data(), n);
+        REQUIRE(r == want);
+
+        for (std::size_t i = 0; i < n; ++i)
+            want[i] = ~(want[i] | a[i]) ^ a[i];
+        kernels::or_words(r.data(), a.data(), n);
+        kernels::not_words(r.data(), n);
+        kernels::xor_words(r.data(), a.data(), n);
+        REQUIRE(r == want);
+    }
+}
+
+TEST_CASE("kernels – base3_digits") {
+    constexpr std::uint64_t kMax = 12157665459056928801ULL - 1; // 3^40 - 1
+    std::mt19937_64 rng(11);
+    std::vector<std::uint64_t> xs = {0, 1, 2, 3, 59048, 59049, kMax};
+    for (int i = 0; i < 2000; ++i)
+        xs.push_back(rng() % (kMax + 1));
+
+    for (std::uint64_t x : xs)
+        for (std::size_t n : {0, 1, 9, 10, 15, 16, 23, 39, 40}) {
+            std::uint8_t got[40] = {}, want[40] = {};
+            std::uint64_t y = x;
+            for (std::size_t i = 0; i < n; ++i, y /= 3)
+                want[i] = std::uint8_t(y % 3);
+            kernels::base3_digits(x, got, n);
+            for (std::size_t i = 0; i < 40; ++i)
+                REQUIRE(got[i] == want[i]);
+        }
+
+    /* the limb division trick holds for every limb value */
+    for (std::uint64_t limb = 0; limb < 59049; ++limb) {
+        std::uint8_t got[40];
+        kernels::base3_digits(limb * 59049 * 59049 + limb, got, 40);
+        std::uint64_t y = limb;
+        for (int i = 0; i < 10; ++i, y /= 3) {
+            REQUIRE(got[i] == y % 3);
+            REQUIRE(got[20 + i] == y % 3);
+        }
+    }
+}
+
+TEST_CASE("kernels – unpack_bits / pack_bits round trip") {
+    std::mt19937 rng(3);
+    for (std::size_t n = 0; n <= 130; ++n) {
+        std::vector<std::uint32_t> bits((n + 31) / 32 + 1);
+        for (auto &w : bits)
+            w = rng();
+        std::vector<std::uint8_t> bytes(n, 9);
+        kernels::unpack_bits(bits.data(), bytes.data(), n);
+        for (std::size_t i = 0; i < n; ++i)
+            REQUIRE(bytes[i] == (bits[i >> 5] >> (i & 31) & 1));
+
+        std::vector<std::uint32_t> packed((n + 31) / 32, 0xDEADBEEF);
+        kernels::pack_bits(bytes.data(), packed.data(), n);
+        for (std::size_t w = 0; w < packed.size(); ++w) {
+            std::uint32_t keep =
+                (w + 1) * 32 <= n ? ~0u : (1u << (n & 31)) - 1;
+            REQUIRE(packed[w] == (bits[w] & keep));
+        }
+    }
+}
@@ -0,0 +1,166 @@
+#include "compute.h"
+#include "compute_data.h"
+#include "parallel.h"
+#include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <stdexcept>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────
+// split_range
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("split_range – contiguous cover of the range") {
+    bigint start = prefixN[3] + 5, end = prefixN[9] + 1234;
+    auto chunks = split_range(start, end, 64);
+    REQUIRE(!chunks.empty());
+    REQUIRE(chunks.size() <= 64);
+    REQUIRE(chunks.front().begin == start);
+    REQUIRE(chunks.back().end == end);
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        REQUIRE(chunks[i].begin < chunks[i].end);
+        if (i)
+            REQUIRE(chunks[i].begin == chunks[i - 1].end);
+    }
+
+    REQUIRE(split_range(7, 7, 4).empty());
+    REQUIRE(split_range(0, 3, 10).size() <= 3);
+}
+
+TEST_CASE("split_range – balances by expression size") {
+    /* a range straddling sizes 1 and 8: size-1 indices are cheaper, so the
+     * chunks covering them must hold more indices */
+    bigint start = prefixN[0], end = prefixN[7] + (prefixN[1] - prefixN[0]);
+    auto chunks = split_range(start, end, 4);
+    REQUIRE(chunks.size() == 4);
+    REQUIRE(chunks.front().end - chunks.front().begin >
+            chunks.back().end - chunks.back().begin);
+}
+
+// ─────────────────────────────────────────────────────────────
+// enumerate_range / enumerate_chunks
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("enumerate_range – visits every index once") {
+    bigint start = prefixN[4] - 50, end = start + 200000;
+    std::size_t len = std::size_t(end - start);
+    std::vector<std::atomic<int>> seen(len);
+    std::atomic<bool> mismatch{false};
+
+    EnumerateOptions opts;
+    opts.threads = 4;
+    enumerate_range(
+        start, end,
+        [&](const ExprCursor &cur, unsigned) {
+            seen[std::size_t(cur.index() - start)]++;
+            if (cur.index() % 97 == 0 && cur.expr() != get_expr(cur.index()))
+                mismatch = true;
+        },
+        opts);
+
+    REQUIRE_FALSE(mismatch);
+    REQUIRE(std::all_of(seen.begin(), seen.end(),
+                        [](auto &s) { return s == 1; }));
+}
+
+TEST_CASE("enumerate_chunks – per-worker sinks see their chunk start") {
+    std::mutex mu;
+    std::vector<RangeChunk> got;
+    std::atomic<bool> bad{false};
+    EnumerateOptions opts;
+    opts.threads = 3;
+    opts.chunksPerThread = 5;
+    enumerate_chunks(
+        0, 20000,
+        [&](const RangeChunk &c, ExprCursor &cur, unsigned w) {
+            if (cur.index() != c.begin || w >= 3)
+                bad = true;
+            std::lock_guard lock(mu);
+            got.push_back(c);
+        },
+        opts);
+    REQUIRE_FALSE(bad);
+    std::sort(got.begin(), got.end(),
+              [](auto &a, auto &b) { return a.begin < b.begin; });
+    REQUIRE(got.front().begin == 0);
+    REQUIRE(got.back().end == 20000);
+    for (std::size_t i = 1; i < got.size(); ++i)
+        REQUIRE(got[i].begin == got[i - 1].end);
+}
+
+TEST_CASE("enumerate_range – rethrows the first callback error") {
+    EnumerateOptions opts;
+    opts.threads = 4;
+    REQUIRE_THROWS_AS(enumerate_range(
+                          0, 50000,
+                          [](const ExprCursor &cur, unsigned) {
+                              if (cur.index() == 31337)
+                                  throw std::runtime_error("boom");
+                          },
+                          opts),
+                      std::runtime_error);
+}
+
+TEST_CASE("enumerate_chunks – calls share one pool, nested calls run inline") {
+    EnumerateOptions opts;
+    opts.threads = 3;
+    auto thread_ids = [&] {
+        std::mutex mu;
+        std::set<std::thread::id> ids;
+        enumerate_chunks(
+            0, 30000,
+            [&](const RangeChunk &, ExprCursor &, unsigned) {
+                std::lock_guard lock(mu);
+                ids.insert(std::this_thread::get_id());
+            },
+            opts);
+        return ids;
+    };
+    /* no fresh threads per call: both draw on the same three workers */
+    auto all = thread_ids();
+    all.merge(thread_ids());
+    REQUIRE(all.size() <= 3);
+    REQUIRE_FALSE(all.count(std::this_thread::get_id()));
+
+    std::atomic<std::uint64_t> inner{0};
+    std::atomic<bool> bad{false};
+    enumerate_chunks(
+        0, 300,
+        [&](const RangeChunk &, ExprCursor &, unsigned) {
+            auto self = std::this_thread::get_id();
+            enumerate_range(
+                0, 100,
+                [&](const ExprCursor &, unsigned w) {
+                    if (w != 0 || std::this_thread::get_id() != self)
+                        bad = true;
+                    ++inner;
+                },
+                opts);
+        },
+        opts);
+    REQUIRE_FALSE(bad);
+    REQUIRE(inner > 0);
+    REQUIRE(inner % 100 == 0);
+}
+
+// ─────────────────────────────────────────────────────────────
+// get_expr_range_parallel
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("get_expr_range_parallel – matches the sequential batch") {
+    EnumerateOptions opts;
+    opts.threads = 4;
+    bigint start = prefixN[3] - 17;
+    REQUIRE(get_expr_range_parallel(start, 5000, opts) ==
+            get_expr_range(start, 5000));
+    REQUIRE(get_expr_range_full_parallel(start, 700, opts) ==
+            get_expr_range_full(start, 700));
+    REQUIRE(get_expr_range_parallel(start, 0, opts).empty());
+    REQUIRE(get_expr_range_full_parallel(start, 0, opts) == "[]");
+
+    /* stops at the end of the enumeration like the sequential form */
+    bigint last = prefixN[size_limit()] - 3;
+    REQUIRE(get_expr_range_parallel(last, 10, opts) ==
+            get_expr_range(last, 10));
+}
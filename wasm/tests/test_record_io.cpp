@@ -0,0 +1,165 @@
+#include "compute.h"
+#include "compute_data.h"
+#include "cursor.h"
+#include "record_io.h"
+#include <algorithm>
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+/* Temporary file removed on scope exit */
+struct TempFile {
+    std::string path = "/tmp/circfinity_recXXXXXX";
+    int fd;
+    TempFile() { fd = ::mkstemp(path.data()); }
+    ~TempFile() {
+        if (fd >= 0)
+            ::close(fd);
+        ::unlink(path.c_str());
+    }
+};
+
+void write_range(int fd, const bigint &start, int count) {
+    ExprCursor cur(start);
+    RecordWriter out(fd, start, ExprCursor(start + count - 1).size(), 4096);
+    for (int i = 0; i < count; ++i) {
+        out.append(cur.signature(), cur.ops(), cur.labels());
+        cur.next();
+    }
+    out.finish();
+}
+
+} // namespace
+
+TEST_CASE("RecordWriter / RecordReader – round-trip and seek") {
+    TempFile f;
+    REQUIRE(f.fd >= 0);
+    bigint start = prefixN[4] + 17;
+    const int count = 5000; // several index strides, crosses into size 6
+    write_range(f.fd, start, count);
+
+    RecordReader in(f.path);
+    REQUIRE(in.size() == count);
+    REQUIRE(in.start() == start);
+
+    /* sequential */
+    ExprCursor cur(start);
+    ExprRecord r;
+    for (int i = 0; i < count; ++i) {
+        REQUIRE(in.next(r));
+        REQUIRE(r.sig == cur.signature());
+        REQUIRE(r.ops == cur.ops());
+        REQUIRE(r.labels == cur.labels());
+        cur.next();
+    }
+    REQUIRE_FALSE(in.next(r));
+
+    /* random access, including stride boundaries */
+    for (std::uint64_t k : {0u, 1u, 1023u, 1024u, 1025u, 3333u, 4999u}) {
+        auto rec = in.read(k);
+        REQUIRE(emit_expr(rec.sig, rec.ops, rec.labels) ==
+                get_expr(start + k));
+    }
+    REQUIRE_THROWS_AS(in.read(count), std::runtime_error);
+}
+
+TEST_CASE("RecordWriter – wide labels and empty files") {
+    TempFile f;
+    REQUIRE(f.fd >= 0);
+    set_size_limit(300);
+    bigint start = prefixN[300] - 1; // s = 301, labels 0..300
+    {
+        ExprCursor cur(start);
+        RecordWriter out(f.fd, start, 300);
+        out.append(cur.signature(), cur.ops(), cur.labels());
+        out.finish();
+        set_size_limit(kDefaultSizeLimit);
+    }
+    RecordReader in(f.path);
+    REQUIRE(in.start() == start);
+    auto rec = in.read(0);
+    REQUIRE(rec.labels.size() == 301);
+    REQUIRE(rec.labels.back() == 300);
+
+    TempFile empty;
+    RecordWriter(empty.fd, 0, 0).finish();
+    RecordReader none(empty.path);
+    REQUIRE(none.size() == 0);
+    REQUIRE(none.start() == 0);
+    ExprRecord r;
+    REQUIRE_FALSE(none.next(r));
+}
+
+TEST_CASE("RecordReader – rejects other files") {
+    TempFile f;
+    REQUIRE(f.fd >= 0);
+    std::string junk(64, 'x');
+    REQUIRE(::write(f.fd, junk.data(), junk.size()) == 64);
+    REQUIRE_THROWS_AS(RecordReader(f.path), std::runtime_error);
+    REQUIRE_THROWS_AS(RecordReader("/nonexistent/circfinity"),
+                      std::runtime_error);
+}
+
+TEST_CASE("RecordReader – rejects corrupt layouts") {
+    TempFile f;
+    REQUIRE(f.fd >= 0);
+    write_range(f.fd, prefixN[4], 3000); // three index entries
+    std::string good(std::size_t(::lseek(f.fd, 0, SEEK_END)), '\0');
+    REQUIRE(::pread(f.fd, good.data(), good.size(), 0) ==
+            ssize_t(good.size()));
+
+    auto put = [](std::string &s, std::size_t at, std::uint64_t v, int bytes) {
+        for (int i = 0; i < bytes; ++i)
+            s[at + i] = char(v >> (8 * i) & 0xFF);
+    };
+    auto get = [](const std::string &s, std::size_t at) {
+        std::uint64_t v = 0;
+        for (int i = 0; i < 8; ++i)
+            v |= std::uint64_t(std::uint8_t(s[at + i])) << (8 * i);
+        return v;
+    };
+    const std::size_t foot = good.size() - 24;
+    const std::uint64_t end = get(good, foot + 8);
+    auto open = [](const std::string &bytes) {
+        TempFile t;
+        REQUIRE(::write(t.fd, bytes.data(), bytes.size()) ==
+                ssize_t(bytes.size()));
+        RecordReader in(t.path);
+        ExprRecord r;
+        while (in.next(r)) {
+        }
+    };
+    REQUIRE_NOTHROW(open(good));
+
+    auto bad = good;
+    put(bad, 16, 0, 4); // stride
+    REQUIRE_THROWS_WITH(open(bad), Catch::Matchers::StartsWith(
+                                       "Not a record file"));
+    bad = good;
+    put(bad, 20, 0xFFFFFFFF, 4); // start magnitude runs past the records
+    REQUIRE_THROWS_WITH(open(bad), Catch::Matchers::StartsWith(
+                                       "Not a record file"));
+    bad = good;
+    put(bad, foot + 8, good.size(), 8); // records end past the index
+    REQUIRE_THROWS_WITH(open(bad), Catch::Matchers::StartsWith(
+                                       "Not a record file"));
+    bad = good;
+    put(bad, foot, ~std::uint64_t(0), 8); // count needs a larger index
+    REQUIRE_THROWS_WITH(open(bad), Catch::Matchers::StartsWith(
+                                       "Not a record file"));
+    bad = good;
+    put(bad, end + 8, end, 8); // index entry at the records end
+    REQUIRE_THROWS_WITH(open(bad), Catch::Matchers::StartsWith(
+                                       "Not a record file"));
+
+    /* a shape that never closes stops at the records end */
+    bad = good;
+    std::fill(bad.begin() + 24 + std::ptrdiff_t(get(good, 20) & 0xFFFFFFFF),
+              bad.begin() + std::ptrdiff_t(end), '\xFF');
+    REQUIRE_THROWS_WITH(open(bad), "Corrupt record file");
+}
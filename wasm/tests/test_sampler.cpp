@@ -0,0 +1,116 @@
+#include "compute.h"
+#include "compute_data.h"
+#include "sampler.h"
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+// helpers ---------------------------------------------------------------
+static bigint rank_record(const ExprRecord &r) {
+    bigint opIdx = 0;
+    for (std::size_t i = r.ops.size(); i-- > 0;)
+        opIdx = opIdx * 3 + r.ops[i];
+    return rank_expr_components(r.sig, opIdx, r.labels);
+}
+
+static int leaves(const ExprRecord &r) { return int(r.labels.size()); }
+
+// ─────────────────────────────────────────────────────────────
+// ExprSampler
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("sampler – same seed, same expressions") {
+    ExprSampler a(42), b(42), c(43);
+    std::vector<ExprRecord> ra, rb, rc;
+    a.sample_batch({}, 50, ra);
+    b.sample_batch({}, 50, rb);
+    c.sample_batch({}, 50, rc);
+    std::vector<bigint> ia, ib, ic;
+    for (std::size_t i = 0; i < 50; ++i) {
+        ia.push_back(rank_record(ra[i]));
+        ib.push_back(rank_record(rb[i]));
+        ic.push_back(rank_record(rc[i]));
+    }
+    REQUIRE(ia == ib);
+    REQUIRE(ia != ic);
+}
+
+TEST_CASE("sampler – draws stay inside the requested domain") {
+    ExprSampler smp(7);
+    ExprRecord r;
+    for (int i = 0; i < 200; ++i) {
+        smp.sample({60}, r);
+        bigint N = rank_record(r);
+        REQUIRE(N >= prefixN[59]);
+        REQUIRE(N < prefixN[60]);
+    }
+    for (int i = 0; i < 200; ++i) {
+        smp.sample({150, 40}, r);
+        REQUIRE(leaves(r) == 40);
+        REQUIRE(r.sig.size() == std::size_t(2 * 40 + (150 - 40 + 1) - 1));
+        REQUIRE(get_expr(rank_record(r)) ==
+                emit_expr(r.sig, r.ops, r.labels));
+    }
+    smp.sample({}, r);
+    REQUIRE(rank_record(r) < prefixN[size_limit()]);
+
+    REQUIRE_THROWS_AS(smp.sample({5, 7}, r), std::runtime_error);
+    REQUIRE_THROWS_AS(smp.sample({-1, 2}, r), std::runtime_error);
+    REQUIRE_THROWS_AS(smp.sample({size_limit() + 1}, r), std::runtime_error);
+}
+
+TEST_CASE("sampler – uniform over a small size") {
+    const int n = 3;
+    const bigint base = prefixN[n - 1];
+    const int W = int(Wn[n]);
+    const int perCell = 100;
+    ExprSampler smp(2024);
+    std::map<int, int> counts;
+    ExprRecord r;
+    for (int i = 0; i < W * perCell; ++i) {
+        smp.sample({n}, r);
+        ++counts[int(rank_record(r) - base)];
+    }
+    REQUIRE(int(counts.size()) == W);
+    /* chi-square with W - 1 degrees of freedom, far out in the tail */
+    double chi2 = 0;
+    for (auto [idx, c] : counts)
+        chi2 += double(c - perCell) * (c - perCell) / perCell;
+    REQUIRE(chi2 < W + 6 * std::sqrt(2.0 * W));
+}
+
+TEST_CASE("sampler – arena batch matches compact records") {
+    ExprSampler a(99), b(99);
+    std::vector<ExprRecord> recs;
+    FlatBatch batch;
+    a.sample_batch({40}, 30, recs);
+    b.sample_batch({40}, 30, batch);
+    REQUIRE(batch.size() == 30);
+    REQUIRE(batch.start.back() == batch.nodes.size());
+    for (std::size_t i = 0; i < recs.size(); ++i) {
+        FlatExpr e;
+        e.nodes.assign(batch.nodes.begin() + batch.start[i],
+                       batch.nodes.begin() + batch.start[i + 1]);
+        e.vars = batch.vars[i];
+        std::string text;
+        emit_flat(e, text);
+        REQUIRE(text == emit_expr(recs[i].sig, recs[i].ops, recs[i].labels));
+    }
+}
+
+TEST_CASE("sampler – below() is uniform and in range") {
+    ExprSampler smp(5);
+    bigint wide = (bigint(1) << 200) + 12345;
+    for (int i = 0; i < 100; ++i) {
+        bigint v = smp.below(wide);
+        REQUIRE(v >= 0);
+        REQUIRE(v < wide);
+    }
+    int hits[3] = {};
+    for (int i = 0; i < 3000; ++i)
+        ++hits[int(smp.below(3))];
+    for (int h : hits)
+        REQUIRE(std::abs(h - 1000) < 150);
+    REQUIRE_THROWS_AS(smp.below(0), std::runtime_error);
+}
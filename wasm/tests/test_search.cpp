@@ -0,0 +1,52 @@
+#include "search.h"
+#include "compute_data.h"
+#include <catch2/catch_all.hpp>
+#include <map>
+
+TEST_CASE("search – first index of every function up to size 4") {
+    std::map<std::pair<int, std::uint64_t>, bigint> first;
+    for (bigint N = 0; N < prefixN[4]; ++N) {
+        auto tt = truth_table(N);
+        if (tt.vars <= kMaxSearchVars)
+            first.try_emplace({tt.vars, tt.words[0]}, N);
+    }
+    REQUIRE(first.size() > 100);
+    for (const auto &[key, N] : first) {
+        auto found = find_min_index(key.first, key.second);
+        REQUIRE(found);
+        REQUIRE(*found == N);
+    }
+}
+
+TEST_CASE("search – results round-trip through get_expr") {
+    SearchOptions opts;
+    opts.maxSize = 12;
+    for (int vars = 1; vars <= 3; ++vars)
+        for (std::uint64_t mask = 0; mask < (1u << (1u << vars)); ++mask) {
+            auto found = find_min_index(vars, mask, opts);
+            REQUIRE(found);
+            TruthTable want{vars, {mask}};
+            REQUIRE(truth_table(*found) == want);
+            REQUIRE(rank_expr(get_expr(*found)) == *found);
+            REQUIRE(find_min_index(want, opts) == found);
+        }
+}
+
+TEST_CASE("search – four variables and bounds") {
+    /* parity needs three XORs and nothing smaller */
+    auto parity = find_min_index(4, 0x6996);
+    REQUIRE(parity);
+    REQUIRE(*parity >= prefixN[2]);
+    REQUIRE(*parity < prefixN[3]);
+    REQUIRE(truth_table(*parity) == TruthTable{4, {0x6996}});
+
+    SearchOptions tight;
+    tight.maxSize = 2;
+    REQUIRE_FALSE(find_min_index(4, 0x6996, tight));
+
+    REQUIRE_THROWS_AS(find_min_index(0, 0), std::runtime_error);
+    REQUIRE_THROWS_AS(find_min_index(5, 0), std::runtime_error);
+    REQUIRE_THROWS_AS(find_min_index(2, 0x10), std::runtime_error);
+    REQUIRE_THROWS_AS(find_min_index(TruthTable{7, {0, 0}}),
+                      std::runtime_error);
+}
@@ -0,0 +1,129 @@
+#include "compute.h"
+#include "compute_data.h"
+#include "tiered.h"
+#include <catch2/catch_all.hpp>
+#include <vector>
+
+using namespace tiered;
+
+// helpers ---------------------------------------------------------------
+template <class Int> static void require_tier_matches(const bigint &N) {
+    std::string sigRef, sig;
+    bigint opRef;
+    Int op;
+    std::vector<int> lblRef, lbl;
+    tiered::compute_expr_components<bigint>(N, sigRef, opRef, lblRef);
+    tiered::compute_expr_components<Int>(Int(N), sig, op, lbl);
+    INFO("N=" << N);
+    REQUIRE(sig == sigRef);
+    REQUIRE(widen(op) == opRef);
+    REQUIRE(lbl == lblRef);
+}
+
+// ─────────────────────────────────────────────────────────────
+// narrow / dispatch
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("narrow – saturates at the tier maximum") {
+    REQUIRE(narrow<u64>(bigint(42)) == 42u);
+    REQUIRE(narrow<u64>(bigint(1) << 64) == ~u64(0));
+    REQUIRE(narrow<u128>(bigint(1) << 100) == u128(1) << 100);
+    REQUIRE(narrow<u128>(prefixN[100]) == ~u128(0));
+    REQUIRE(widen(narrow<u1024>(prefixN[100])) == prefixN[100]);
+    REQUIRE(widen(narrow<u1024>(bigint(1) << 1100)) == widen(~u1024(0)));
+}
+
+TEST_CASE("dispatch – picks the narrowest tier") {
+    auto tier = [](const bigint &N) {
+        return dispatch(N, [](const auto &v) -> int {
+            using T = std::decay_t<decltype(v)>;
+            return std::is_same_v<T, u64>     ? 64
+                   : std::is_same_v<T, u128>  ? 128
+                   : std::is_same_v<T, u1024> ? 1024
+                                              : 0;
+        });
+    };
+    REQUIRE(tier(0) == 64);
+    REQUIRE(tier((bigint(1) << 63) - 1) == 64);
+    REQUIRE(tier(bigint(1) << 63) == 128);
+    REQUIRE(tier(bigint(1) << 127) == 1024);
+    REQUIRE(tier(prefixN[100] - 1) == 1024);
+    REQUIRE(tier(prefixN[kDefaultSizeLimit] - 1) == 0);
+    REQUIRE(tier(bigint(1) << 1023) == 0);
+}
+
+// ─────────────────────────────────────────────────────────────
+// compute_expr_components per tier
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("tiers – agree with the bigint tier") {
+    std::vector<bigint> small{0, 1, 2, 8, 21, 1000, 123456789};
+    for (int n = 1; n <= kDefaultSizeLimit; n += 7)
+        small.push_back(prefixN[n] - 1);
+
+    for (const bigint &N : small) {
+        if (N < (bigint(1) << 63))
+            require_tier_matches<u64>(N);
+        if (N < (bigint(1) << 127))
+            require_tier_matches<u128>(N);
+        if (N < (bigint(1) << 1023))
+            require_tier_matches<u1024>(N);
+    }
+}
+
+TEST_CASE("tiers – unrank_shape & unrank_rgs agree") {
+    for (int s = 1; s <= 5; ++s)
+        for (int u = 0; u <= 3; ++u)
+            for (u64 k = 0; k < narrow<u64>(C[s][u]); ++k) {
+                REQUIRE(tiered::unrank_shape<u64>(s, u, k) ==
+                        tiered::unrank_shape<bigint>(s, u, k));
+                REQUIRE(tiered::unrank_shape<u1024>(s, u, k) ==
+                        tiered::unrank_shape<bigint>(s, u, k));
+            }
+    for (u64 k = 0; k < 52; ++k)
+        REQUIRE(tiered::unrank_rgs<u128>(6, k) ==
+                tiered::unrank_rgs<bigint>(6, k));
+    REQUIRE(tiered::emit_expr<u64>("BBLLL", 5, {0, 1, 2}) ==
+            "XOR(OR(A,B),C)");
+}
+
+TEST_CASE("unrank_shape – round-trips at large sizes") {
+    for (auto [s, u] : {std::pair{40, 0}, {30, 25}, {100, 99}, {3, 150}}) {
+        const bigint &total = C[s][u];
+        for (bigint k : std::vector<bigint>{0, 1, total / 3, total / 2,
+                                            total - 1}) {
+            INFO("s=" << s << " u=" << u << " k=" << k);
+            std::string sig = unrank_shape(s, u, k);
+            REQUIRE(sig.size() == std::size_t(2 * s + u - 1));
+            REQUIRE(rank_shape(sig) == k);
+            if (k < (bigint(1) << 1023))
+                REQUIRE(tiered::unrank_shape<u1024>(s, u, narrow<u1024>(k)) ==
+                        sig);
+        }
+    }
+}
+
+TEST_CASE("decode_ops – chunked digits match base 3") {
+    auto digits = [](bigint v, std::size_t count) {
+        std::vector<std::uint8_t> d(count);
+        for (auto &x : d) {
+            x = std::uint8_t(v % 3);
+            v /= 3;
+        }
+        return d;
+    };
+    std::string sig;
+    for (int b = 0; b < 130; ++b)
+        sig += "BL";
+    sig += 'L';
+    std::vector<bigint> values{0, 1, 2, Pow3[40] - 1, Pow3[40], Pow3[41] + 5,
+                               Pow3[99] / 7, Pow3[130] - 1};
+    for (const bigint &v : values) {
+        INFO("opIdx=" << v);
+        auto ref = digits(v, 130);
+        REQUIRE(decode_ops(sig, v) == ref);
+        if (v < (bigint(1) << 63))
+            REQUIRE(tiered::decode_ops(sig, narrow<u64>(v)) == ref);
+        if (v < (bigint(1) << 127))
+            REQUIRE(tiered::decode_ops(sig, narrow<u128>(v)) == ref);
+        REQUIRE(tiered::decode_ops(sig, narrow<u1024>(v)) == ref);
+    }
+}
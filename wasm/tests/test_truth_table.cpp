@@ -0,0 +1,88 @@
+#include "compute.h"
+#include "compute_data.h"
+#include "truth_table.h"
+#include <bit>
+#include <catch2/catch_all.hpp>
+#include <vector>
+
+// helpers ---------------------------------------------------------------
+static bool eval_row(const bigint &N, int vars, std::uint64_t row) {
+    std::string json = "{";
+    for (int v = 0; v < vars; ++v) {
+        if (v)
+            json += ",";
+        json += "\"" + Labels[v] + "\":" + (row >> v & 1 ? "true" : "false");
+    }
+    json += "}";
+    return evaluate_expr_full_json(N, json).find("\"n0\":true") !=
+           std::string::npos;
+}
+
+// ─────────────────────────────────────────────────────────────
+// truth_table
+// ─────────────────────────────────────────────────────────────
+TEST_CASE("truth_table – small tables") {
+    auto a = truth_table(bigint(0)); // A
+    REQUIRE(a.vars == 1);
+    REQUIRE(a.words == std::vector<std::uint64_t>{0b10});
+
+    auto nota = truth_table(bigint(1)); // NOT(A)
+    REQUIRE(nota.words == std::vector<std::uint64_t>{0b01});
+
+    auto andab = truth_table(rank_expr("AND(A,B)"));
+    REQUIRE(andab.vars == 2);
+    REQUIRE(andab.words == std::vector<std::uint64_t>{0b1000});
+
+    auto x = truth_table(rank_expr("XOR(A,OR(B,C))"));
+    REQUIRE(x.vars == 3);
+    for (int r = 0; r < 8; ++r)
+        REQUIRE(x.row(r) == bool((r & 1) ^ ((r >> 1 | r >> 2) & 1)));
+}
+
+TEST_CASE("truth_table – matches evaluate_expr_full_json") {
+    for (bigint N = 0; N < 3000; N += 7) {
+        auto tt = truth_table(N);
+        for (std::uint64_t r = 0; r < (1ULL << tt.vars); ++r) {
+            INFO("N=" << N << " row=" << r);
+            REQUIRE(tt.row(r) == eval_row(N, tt.vars, r));
+        }
+    }
+}
+
+TEST_CASE("truth_table – multi-word tables") {
+    /* XOR(A,XOR(B,…)) over 8 labels spans 4 words */
+    std::string sig;
+    for (int i = 0; i < 7; ++i)
+        sig += "BL";
+    sig += 'L';
+    std::vector<std::uint8_t> ops(7, 2);
+    std::vector<int> labels{0, 1, 2, 3, 4, 5, 6, 7};
+    auto tt = truth_table(sig, ops, labels);
+    REQUIRE(tt.vars == 8);
+    REQUIRE(tt.words.size() == 4);
+    for (std::uint64_t r = 0; r < 256; ++r)
+        REQUIRE(tt.row(r) == bool(std::popcount(r) & 1));
+
+    bigint N = rank_expr_components(sig, Pow3[7] - 1, labels);
+    REQUIRE(truth_table(N).words == tt.words);
+    for (std::uint64_t r : {0u, 1u, 77u, 128u, 255u})
+        REQUIRE(tt.row(r) == eval_row(N, 8, r));
+}
+
+TEST_CASE("truth_table – 26 variables") {
+    std::string sig;
+    for (int i = 0; i < 25; ++i)
+        sig += "BL";
+    sig += 'L';
+    std::vector<int> labels(26);
+    std::iota(labels.begin(), labels.end(), 0);
+    auto tt = truth_table(sig, std::vector<std::uint8_t>(25, 1), labels);
+    REQUIRE(tt.words.size() == (1u << 20));
+    REQUIRE(tt.words[0] == ~1ULL);
+    REQUIRE(std::all_of(tt.words.begin() + 1, tt.words.end(),
+                        [](std::uint64_t w) { return w == ~0ULL; }));
+
+    labels.push_back(26);
+    REQUIRE_THROWS(
+        truth_table("BL" + sig, std::vector<std::uint8_t>(26, 1), labels));
+}
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Generates the enumeration tables as 64-bit limb arrays.
+
+Emits one layer per total size n = 0…size, laid out the way
+compute_data.h's SizeLayer stores them, so the module embeds the common
+sizes as constant data and does no arithmetic when it loads. The
+formulas are the ones compute_data.cpp uses to grow past `size`.
+"""
+
+import argparse
+from math import comb
+
+
+def layers(size):
+    """Yields (Pow3, Bell, C diagonal, DP_RGS diagonal, Wn, prefixN)."""
+    pow3, bell = [], [1]
+    c = {}   # (s, u) -> count of shapes
+    dp = {(0, 0): 1}
+    prefix = 0
+    for n in range(size + 1):
+        e = n + 1
+        pow3.append(3**n)
+
+        # RGS completions: DP[l][m] = (m+1)·DP[l-1][m] + DP[l-1][m+1]
+        dp[0, e] = 1
+        for l in range(1, e + 1):
+            m = e - l
+            dp[l, m] = (m + 1) * dp[l - 1, m] + dp[l - 1, m + 1]
+        bell.append(dp[n, 0])
+
+        # shapes: C[s][u] = Cat(s-1)·binom(s-1+u, u), since one leaf has
+        # one shape per unary count and larger shapes are B-rooted splits
+        # only (the original table never added the U-rooted block into
+        # C[s][u] for s >= 2)
+        for s in range(1, e + 1):
+            u = e - s
+            c[s, u] = comb(2 * s - 2, s - 1) // s * comb(s - 1 + u, u)
+
+        w = sum(c[n - u + 1, u] * pow3[n - u] * bell[n - u + 1]
+                for u in range(n + 1))
+        prefix += w
+        yield (pow3[n], bell[n + 1], [c[i + 1, n - i] for i in range(n + 1)],
+               [dp[l, e - l] for l in range(e + 1)], w, prefix)
+
+
+def label(i):
+    s = ""
+    while True:
+        s = chr(ord("A") + i % 26) + s
+        i //= 26
+        if i == 0:
+            return s
+        i -= 1
+
+
+def limbs(v):
+    out = []
+    while v:
+        out.append(v & (2**64 - 1))
+        v >>= 64
+    return out
+
+
+def emit(out, size):
+    pool = []
+    cols = {k: [] for k in ("Pow3", "Bell", "C", "DP_RGS", "Wn", "prefixN")}
+
+    def ref(v):
+        ls = limbs(v)
+        off = len(pool)
+        pool.extend(ls)
+        return "{%d,%d}" % (off, len(ls))
+
+    for pow3, bell, cdiag, dpdiag, w, prefix in layers(size):
+        cols["Pow3"].append(ref(pow3))
+        cols["Bell"].append(ref(bell))
+        cols["C"].extend(ref(v) for v in cdiag)
+        cols["DP_RGS"].extend(ref(v) for v in dpdiag)
+        cols["Wn"].append(ref(w))
+        cols["prefixN"].append(ref(prefix))
+
+    w = out.write
+    w("// Generated by tools/gen_tables.py - do not edit.\n")
+    w("constexpr int kGenSize = %d;\n\n" % size)
+    w("constexpr std::uint64_t kLimbs[] = {\n")
+    for i in range(0, len(pool), 4):
+        w("    " + ", ".join("0x%016xULL" % x for x in pool[i:i + 4]) + ",\n")
+    w("};\n\n")
+    for name, refs in cols.items():
+        w("constexpr LimbRef kGen%s[%d] = {\n" % (name, len(refs)))
+        for i in range(0, len(refs), 8):
+            w("    " + ",".join(refs[i:i + 8]) + ",\n")
+        w("};\n\n")
+    w("constexpr const char *kGenLabels[%d] = {\n" % (size + 1))
+    for i in range(0, size + 1, 10):
+        w("    " + ", ".join('"%s"' % label(j)
+                             for j in range(i, min(i + 10, size + 1))) + ",\n")
+    w("};\n")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__)
+    ap.add_argument("--size", type=int, required=True,
+                    help="largest total size n to embed")
+    ap.add_argument("-o", "--output", required=True)
+    args = ap.parse_args()
+    with open(args.output, "w") as f:
+        emit(f, args.size)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,7 @@
+# cmake -DFROM=<dir> -DNAME=<target> -DTO=<dir> -P publish_wasm.cmake
+file(MAKE_DIRECTORY ${TO})
+foreach(ext js wasm worker.js)
+  if(EXISTS ${FROM}/${NAME}.${ext})
+    file(COPY_FILE ${FROM}/${NAME}.${ext} ${TO}/${NAME}.${ext} ONLY_IF_DIFFERENT)
+  endif()
+endforeach()